@@ -0,0 +1,213 @@
+#include <algorithm>
+
+using namespace std;
+
+#include "connectivity.h"
+
+
+/* offsets of the eight neighbours of a cell */
+static const int neighbour_dr[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+static const int neighbour_dc[8] = {0, 0, -1, 1, 1, -1, 1, -1};
+
+/* a station part before the parts are grouped by station */
+struct StationPart {
+  StationId station;
+  char line;
+  uint32_t component;
+
+  bool operator<(const StationPart &other) const {
+    if (station != other.station)
+      return station < other.station;
+    if (line != other.line)
+      return line < other.line;
+    return component < other.component;
+  }
+  bool operator==(const StationPart &other) const {
+    return station == other.station && line == other.line && component == other.component;
+  }
+};
+
+
+/* internal helper which finds the representative of a node, halving the
+   path to it on the way */
+static uint32_t find_root(vector<uint32_t> &parent, uint32_t node) {
+  while (parent[node] != node) {
+    parent[node] = parent[parent[node]];
+    node = parent[node];
+  }
+  return node;
+}
+
+/* internal helper which merges the sets of two nodes, the smaller into the
+   larger */
+static void merge(vector<uint32_t> &parent, vector<uint32_t> &size, uint32_t a, uint32_t b) {
+  a = find_root(parent, a);
+  b = find_root(parent, b);
+  if (a == b)
+    return;
+  if (size[a] < size[b])
+    swap(a, b);
+  parent[b] = a;
+  size[a] += size[b];
+}
+
+
+/* Function to build the components of a map. Nodes 0 to height * width - 1
+   are the cells; a node is added after them for each line touching each
+   station cell. */
+void LineConnectivity::build(const TubeMap &map) {
+  int height = map.get_height();
+  width = map.get_width();
+  size_t cells = (size_t) height * width;
+
+  vector<uint32_t> parent(cells), size(cells, 1);
+  for (size_t n = 0; n < cells; n++)
+    parent[n] = n;
+  unordered_map<uint64_t, uint32_t> copy_at;   // station cell * 256 + line -> node
+  vector<uint32_t> copy_cell;
+  vector<char> copy_line;
+
+  /* each line on its own: track joins track of the same line, and the copy
+     of a station cell for that line */
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      char line = map.cell(r, c);
+      if (line == ' ' || map.is_station(r, c))
+        continue;
+      for (int d = 0; d < 8; d++) {
+        int nr = r + neighbour_dr[d], nc = c + neighbour_dc[d];
+        if (nr < 0 || nc < 0 || nr >= height || nc >= width)
+          continue;
+        uint32_t next = nr * width + nc;
+        if (map.is_station(nr, nc)) {
+          uint64_t key = (uint64_t) next * 256 + (unsigned char) line;
+          unordered_map<uint64_t, uint32_t>::iterator it = copy_at.find(key);
+          if (it == copy_at.end()) {
+            it = copy_at.insert(make_pair(key, (uint32_t) parent.size())).first;
+            parent.push_back(parent.size());
+            size.push_back(1);
+            copy_cell.push_back(next);
+            copy_line.push_back(line);
+          }
+          merge(parent, size, r * width + c, it->second);
+        } else if (map.cell(nr, nc) == line) {
+          merge(parent, size, r * width + c, next);
+        }
+      }
+    }
+  }
+
+  vector<StationPart> found;
+  for (size_t n = 0; n < copy_cell.size(); n++) {
+    StationPart part = {map.station_at(copy_cell[n] / width, copy_cell[n] % width),
+                        copy_line[n], find_root(parent, cells + n)};
+    found.push_back(part);
+  }
+
+  /* the whole network: every copy of a station cell is the cell itself,
+     and neighbouring station cells are joined */
+  for (size_t n = 0; n < copy_cell.size(); n++)
+    merge(parent, size, copy_cell[n], cells + n);
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      if (!map.is_station(r, c))
+        continue;
+      for (int d = 0; d < 8; d++) {
+        int nr = r + neighbour_dr[d], nc = c + neighbour_dc[d];
+        if (nr >= 0 && nc >= 0 && nr < height && nc < width && map.is_station(nr, nc))
+          merge(parent, size, r * width + c, nr * width + nc);
+      }
+    }
+  }
+
+  /* fragments, in order of first cell, with the stations in each */
+  pieces.clear();
+  unordered_map<uint32_t, uint32_t> piece_of;   // root -> fragment
+  vector<pair<uint32_t, StationId> > piece_stations;
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      if (map.cell(r, c) == ' ')
+        continue;
+      uint32_t at = r * width + c;
+      uint32_t root = find_root(parent, at);
+      unordered_map<uint32_t, uint32_t>::iterator it = piece_of.find(root);
+      if (it == piece_of.end()) {
+        Fragment piece = {at, 0, 0};
+        it = piece_of.insert(make_pair(root, (uint32_t) pieces.size())).first;
+        pieces.push_back(piece);
+      }
+      pieces[it->second].cells++;
+
+      if (map.is_station(r, c)) {
+        StationId id = map.station_at(r, c);
+        StationPart part = {id, JUNCTION_STATION, root};
+        found.push_back(part);
+        piece_stations.push_back(make_pair(it->second, id));
+      }
+    }
+  }
+  sort(piece_stations.begin(), piece_stations.end());
+  piece_stations.erase(unique(piece_stations.begin(), piece_stations.end()), piece_stations.end());
+  for (size_t n = 0; n < piece_stations.size(); n++)
+    pieces[piece_stations[n].first].stations++;
+  main_piece = 0;
+  for (size_t n = 1; n < pieces.size(); n++)
+    if (pieces[n].stations > pieces[main_piece].stations)
+      main_piece = n;
+
+  sort(found.begin(), found.end());
+  found.erase(unique(found.begin(), found.end()), found.end());
+  parts.clear();
+  parts_of.clear();
+  for (size_t n = 0; n < found.size(); n++) {
+    if (n == 0 || found[n].station != found[n - 1].station)
+      parts_of[found[n].station].first = parts.size();
+    Part part = {found[n].line, found[n].component};
+    parts.push_back(part);
+    parts_of[found[n].station].second = parts.size();
+  }
+}
+
+/* internal helper which tests whether two stations have a part on the
+   given line in one component */
+bool LineConnectivity::share(StationId a, StationId b, char line) const {
+  unordered_map<StationId, pair<uint32_t, uint32_t> >::const_iterator from = parts_of.find(a);
+  unordered_map<StationId, pair<uint32_t, uint32_t> >::const_iterator to = parts_of.find(b);
+  if (from == parts_of.end() || to == parts_of.end())
+    return false;
+
+  for (uint32_t m = from->second.first; m < from->second.second; m++) {
+    if (parts[m].line != line)
+      continue;
+    for (uint32_t n = to->second.first; n < to->second.second; n++)
+      if (parts[n].line == line && parts[n].component == parts[m].component)
+        return true;
+  }
+  return false;
+}
+
+bool LineConnectivity::stations_connected(StationId a, StationId b) const {
+  return share(a, b, JUNCTION_STATION);
+}
+
+bool LineConnectivity::connected_on_line(StationId a, StationId b, char line) const {
+  return line != JUNCTION_STATION && share(a, b, line);
+}
+
+/* Function to describe the fragments cut off from the main one */
+int LineConnectivity::report(ostream &out) const {
+  int written = 0;
+  for (size_t n = 0; n < pieces.size(); n++) {
+    if (n == main_piece)
+      continue;
+    const Fragment &piece = pieces[n];
+    out << "fragment at row " << piece.first_cell / width << ", column " << piece.first_cell % width
+        << ": " << piece.cells << " cell(s), ";
+    if (piece.stations)
+      out << piece.stations << " station(s) cut off from the rest of the map" << endl;
+    else
+      out << "track joining no station" << endl;
+    written++;
+  }
+  return written;
+}
@@ -0,0 +1,69 @@
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <unordered_map>
+#include <ostream>
+
+#include "tubemap.h"
+
+using namespace std;
+
+/* A piece of a map whose cells are joined by track: every cell of it can
+   be walked to from every other without leaving the track. */
+struct Fragment {
+  uint32_t first_cell;   // row * width + column of its first cell in row-major order
+  uint32_t cells;
+  uint32_t stations;     // distinct stations with a cell in it
+};
+
+
+/* Which stations of a map the track joins at all, and which it joins along
+   a single line. Built once by union-find over the cells of the map: track
+   cells are merged with neighbouring cells of the same line, and with the
+   stations they touch through a copy of each station cell per line, so
+   that lines only meet at stations. Merging the copies of every station
+   cell then gives the whole network.
+
+   The answers are necessary conditions for a journey (the no-reversal rule
+   of validate_route() and the planner's constraints are not considered),
+   so a "no" lets a caller reject a query without walking the map. */
+class LineConnectivity {
+private:
+  struct Part {
+    char line;             // JUNCTION_STATION for the whole network
+    uint32_t component;
+  };
+
+  int width;
+  vector<Part> parts;               // by station, then line, then component
+  unordered_map<StationId, pair<uint32_t, uint32_t> > parts_of; // station -> [first, last)
+  vector<Fragment> pieces;          // in order of first cell
+  uint32_t main_piece;              // the fragment with the most stations
+
+  bool share(StationId a, StationId b, char line) const;
+
+public:
+  LineConnectivity() : width(0), main_piece(0) {}
+
+  /* merges the cells of a loaded map; the map need not outlive this */
+  void build(const TubeMap &map);
+
+  /* true if track joins some cell of station a to some cell of station b */
+  bool stations_connected(StationId a, StationId b) const;
+
+  /* the same along the track of one line, changing at no station */
+  bool connected_on_line(StationId a, StationId b, char line) const;
+
+  size_t fragment_count() const { return pieces.size(); }
+  const Fragment &fragment(size_t n) const { return pieces[n]; }
+
+  /* writes one line for each fragment cut off from the one with the most
+     stations, such as stray track joining no station; returns how many
+     lines it wrote */
+  int report(ostream &out) const;
+};
+
+#endif
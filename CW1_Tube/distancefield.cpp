@@ -0,0 +1,129 @@
+#include <cctype>
+#include <thread>
+
+using namespace std;
+
+#include "distancefield.h"
+
+/* row and column offsets of the eight directions */
+static const int neighbour_dr[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+static const int neighbour_dc[8] = {0, 0, -1, 1, 1, -1, 1, -1};
+
+/* smallest batch worth handing to a thread of its own */
+#define LOOKUPS_PER_THREAD 65536
+
+/* adapters giving TubeMap and load_map() grids the same interface */
+struct TubeMapGrid {
+  const TubeMap &map;
+  TubeMapGrid(const TubeMap &m) : map(m) {}
+  int get_height() const { return map.get_height(); }
+  int get_width() const { return map.get_width(); }
+  char cell(int r, int c) const { return map.cell(r, c); }
+  bool is_station(int r, int c) const { return map.is_station(r, c); }
+  StationId station_at(int r, int c) const { return map.station_at(r, c); }
+};
+
+struct CharGrid {
+  char **map;
+  int height, width;
+  CharGrid(char **m, int h, int w) : map(m), height(h), width(w) {}
+  int get_height() const { return height; }
+  int get_width() const { return width; }
+  char cell(int r, int c) const { return map[r][c]; }
+  bool is_station(int r, int c) const { return isalnum(map[r][c]); }
+  StationId station_at(int r, int c) const { return (unsigned char) map[r][c]; }
+};
+
+/* internal helper which runs the multi-source search over any grid */
+template <class Grid>
+void DistanceField::build_from(const Grid &grid) {
+  height = grid.get_height();
+  width = grid.get_width();
+  nearest.assign((size_t) height * width, NO_STATION);
+  distance.assign((size_t) height * width, UNREACHABLE);
+
+  /* every station cell is a source at distance 0 */
+  vector<uint32_t> queue;
+  for (int r = 0; r < height; r++)
+    for (int c = 0; c < width; c++)
+      if (grid.is_station(r, c)) {
+        uint32_t at = r * width + c;
+        nearest[at] = grid.station_at(r, c);
+        distance[at] = 0;
+        queue.push_back(at);
+      }
+
+  for (size_t head = 0; head < queue.size(); head++) {
+    uint32_t at = queue[head];
+    int r = at / width, c = at % width;
+    char here = grid.cell(r, c);
+    bool here_station = grid.is_station(r, c);
+
+    for (int d = 0; d < 8; d++) {
+      int nr = r + neighbour_dr[d], nc = c + neighbour_dc[d];
+      if (nr < 0 || nc < 0 || nr >= height || nc >= width)
+        continue;
+      uint32_t next = nr * width + nc;
+      if (distance[next] != UNREACHABLE || grid.cell(nr, nc) == ' ')
+        continue;
+      /* track cells only join cells of the same line, or a station */
+      if (!here_station && !grid.is_station(nr, nc) && grid.cell(nr, nc) != here)
+        continue;
+      nearest[next] = nearest[at];
+      distance[next] = distance[at] + 1;
+      queue.push_back(next);
+    }
+  }
+}
+
+/* Function to build the field for a loaded map */
+void DistanceField::build(const TubeMap &map) {
+  build_from(TubeMapGrid(map));
+}
+
+/* Function to build the field for a map from load_map() */
+void DistanceField::build(char **map, int height, int width) {
+  build_from(CharGrid(map, height, width));
+}
+
+/* Function to look up the nearest station to one cell */
+bool DistanceField::nearest_station(int r, int c, StationId &station, uint32_t &steps) const {
+  station = NO_STATION;
+  steps = UNREACHABLE;
+  if (r < 0 || c < 0 || r >= height || c >= width)
+    return false;
+  station = nearest[r * width + c];
+  steps = distance[r * width + c];
+  return station != NO_STATION;
+}
+
+/* Function to look up many cells, in parallel for large batches */
+void DistanceField::nearest_stations(const int rows[], const int cols[], size_t count,
+                                     StationId stations[], uint32_t steps[], int threads) const {
+  struct Lookup {
+    static void range(const DistanceField *field, const int rows[], const int cols[],
+                      size_t begin, size_t end, StationId stations[], uint32_t steps[]) {
+      for (size_t n = begin; n < end; n++)
+        field->nearest_station(rows[n], cols[n], stations[n], steps[n]);
+    }
+  };
+
+  if (threads <= 0)
+    threads = thread::hardware_concurrency();
+  if (threads > (int) (count / LOOKUPS_PER_THREAD))
+    threads = count / LOOKUPS_PER_THREAD;
+  if (threads <= 1) {
+    Lookup::range(this, rows, cols, 0, count, stations, steps);
+    return;
+  }
+
+  vector<thread> workers;
+  size_t chunk = (count + threads - 1) / threads;
+  for (size_t begin = chunk; begin < count; begin += chunk) {
+    size_t end = begin + chunk < count ? begin + chunk : count;
+    workers.push_back(thread(Lookup::range, this, rows, cols, begin, end, stations, steps));
+  }
+  Lookup::range(this, rows, cols, 0, chunk, stations, steps);
+  for (size_t n = 0; n < workers.size(); n++)
+    workers[n].join();
+}
@@ -0,0 +1,55 @@
+#ifndef DISTANCEFIELD_H
+#define DISTANCEFIELD_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "tubemap.h"
+
+using namespace std;
+
+/* distance recorded for cells that cannot reach any station */
+const uint32_t UNREACHABLE = 0xFFFFFFFFu;
+
+/* For every cell of a map, the nearest station along the track and how many
+   steps away it is. Built once by a breadth first search seeded from every
+   station cell at once; moves follow the rules of validate_route(): one of
+   the eight directions, onto track, never from one line's track straight
+   onto another's. Ties go to the station found first in row-major order.
+
+   Cells use the (row, column) coordinates of get_symbol_position(), and the
+   results are kept in two flat arrays indexed by row * width + column, so a
+   query is a pair of array reads. */
+class DistanceField {
+private:
+  int height;
+  int width;
+  vector<StationId> nearest;   // NO_STATION where unreachable
+  vector<uint32_t> distance;   // UNREACHABLE where unreachable
+
+  template <class Grid> void build_from(const Grid &grid);
+
+public:
+  DistanceField() : height(0), width(0) {}
+
+  /* builds the field for a loaded map */
+  void build(const TubeMap &map);
+
+  /* builds the field for a map from load_map(); station IDs are then the
+     station symbols */
+  void build(char **map, int height, int width);
+
+  /* looks up one cell; returns false for cells off the map or with no
+     station reachable along the track */
+  bool nearest_station(int r, int c, StationId &station, uint32_t &steps) const;
+
+  /* looks up count cells given as parallel arrays of rows and columns,
+     filling parallel arrays of stations and step counts (NO_STATION and
+     UNREACHABLE where there is no answer). Large batches are split across
+     threads; threads = 0 uses every core. */
+  void nearest_stations(const int rows[], const int cols[], size_t count,
+                        StationId stations[], uint32_t steps[], int threads = 0) const;
+};
+
+#endif
@@ -0,0 +1,98 @@
+#include <cassert>
+#include <vector>
+#include <thread>
+
+using namespace std;
+
+#include "livemap.h"
+
+
+/* Every thread that reads a LiveTubeMap is given a slot number, shared by
+   all maps and returned for reuse when the thread exits. */
+static mutex slot_numbers_lock;
+static vector<int> free_slot_numbers;
+static int next_slot_number = 0;
+
+struct ThreadSlotNumber {
+  int number;
+
+  ThreadSlotNumber() {
+    lock_guard<mutex> guard(slot_numbers_lock);
+    if (free_slot_numbers.empty()) {
+      number = next_slot_number++;
+    } else {
+      number = free_slot_numbers.back();
+      free_slot_numbers.pop_back();
+    }
+  }
+
+  ~ThreadSlotNumber() {
+    lock_guard<mutex> guard(slot_numbers_lock);
+    free_slot_numbers.push_back(number);
+  }
+};
+
+static thread_local ThreadSlotNumber this_thread_slot;
+
+
+LiveTubeMap::LiveTubeMap() : epoch(1), current(NULL), generation_count(0) {
+  for (int n = 0; n < LIVE_MAP_READER_SLOTS; n++)
+    slots[n].epoch.store(0);
+}
+
+LiveTubeMap::~LiveTubeMap() {
+  delete current.load();
+}
+
+/* Function to load a new snapshot and swap it in. The old snapshot is freed
+   once no reader that might have seen it is still inside its read section. */
+bool LiveTubeMap::reload(const char *map_file, const char *stations_file, const char *lines_file) {
+  lock_guard<mutex> guard(reload_lock);
+
+  TubeNetwork *fresh = new TubeNetwork;
+  if (!fresh->load(map_file, map_file, stations_file, lines_file)) {
+    delete fresh;
+    return false;
+  }
+
+  TubeNetwork *old = current.exchange(fresh);
+  uint64_t swap_epoch = epoch.fetch_add(1) + 1;
+  generation_count.fetch_add(1);
+
+  if (old) {
+    wait_for_readers(swap_epoch);
+    delete old;
+  }
+  return true;
+}
+
+/* internal helper which waits until every reader slot is idle or was
+   entered at or after swap_epoch; such readers loaded the new pointer */
+void LiveTubeMap::wait_for_readers(uint64_t swap_epoch) const {
+  for (int n = 0; n < LIVE_MAP_READER_SLOTS; n++) {
+    for (;;) {
+      uint64_t entered = slots[n].epoch.load();
+      if (entered == 0 || entered >= swap_epoch)
+        break;
+      this_thread::yield();
+    }
+  }
+}
+
+/* Function to enter a read section: publish the epoch in this thread's slot,
+   then load the snapshot pointer (both sequentially consistent, so a reload
+   either sees the slot or this load sees its new snapshot) */
+LiveTubeMap::Reader::Reader(LiveTubeMap &live) {
+  assert(this_thread_slot.number < LIVE_MAP_READER_SLOTS);
+  slot = &live.slots[this_thread_slot.number].epoch;
+  outermost = slot->load(memory_order_relaxed) == 0;
+  if (outermost)
+    slot->store(live.epoch.load());
+  snapshot = live.current.load();
+}
+
+/* Function to leave a read section */
+LiveTubeMap::Reader::~Reader() {
+  if (outermost)
+    slot->store(0, memory_order_release);
+}
@@ -0,0 +1,70 @@
+#ifndef LIVEMAP_H
+#define LIVEMAP_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+
+#include "tubenetwork.h"
+
+using namespace std;
+
+/* most threads that can hold a read section on a LiveTubeMap at once */
+#define LIVE_MAP_READER_SLOTS 256
+
+/* A tube map that can be replaced while queries keep running.
+
+   reload() builds a complete new TubeNetwork off to the side, publishes it
+   with a single atomic pointer swap, then waits for a grace period before
+   freeing the old one. Readers are never blocked: a Reader records the
+   current epoch in its thread's slot and loads the snapshot pointer, and
+   the old snapshot is only deleted once every slot is either idle or was
+   entered after the swap. In-flight queries therefore finish on the
+   snapshot they started with. */
+class LiveTubeMap {
+private:
+  struct Slot {
+    alignas(64) atomic<uint64_t> epoch;  // 0 when the thread is not reading
+  };
+
+  Slot slots[LIVE_MAP_READER_SLOTS];
+  atomic<uint64_t> epoch;
+  atomic<TubeNetwork *> current;
+  atomic<uint64_t> generation_count;
+
+  mutex reload_lock;  // one reload at a time
+
+  void wait_for_readers(uint64_t swap_epoch) const;
+
+public:
+  LiveTubeMap();
+  ~LiveTubeMap();
+
+  /* builds a network from the given files and publishes it; returns false,
+     leaving the current snapshot in place, if the files cannot be loaded.
+     Waits out the grace period itself, so it must not be called from
+     inside a read section. */
+  bool reload(const char *map_file, const char *stations_file, const char *lines_file);
+
+  /* number of snapshots published so far */
+  uint64_t generation() const { return generation_count.load(); }
+
+  /* A read section. The snapshot it returns stays valid until the Reader is
+     destroyed; Readers on the same map may nest within one thread. */
+  class Reader {
+  private:
+    atomic<uint64_t> *slot;
+    bool outermost;
+    const TubeNetwork *snapshot;
+
+  public:
+    Reader(LiveTubeMap &live);
+    ~Reader();
+
+    /* NULL until the first successful reload() */
+    const TubeNetwork *get() const { return snapshot; }
+    const TubeNetwork *operator->() const { return snapshot; }
+  };
+};
+
+#endif
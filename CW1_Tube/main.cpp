@@ -5,6 +5,15 @@
 using namespace std;
 
 #include "tube.h"
+#include "tubemap.h"
+#include "prefixindex.h"
+#include "tubenetwork.h"
+#include "distancefield.h"
+#include "maprender.h"
+#include "stationgraph.h"
+#ifdef TUBE_EMBEDDED
+#include "tubeembedded.h"
+#endif
 
 int main() {
 
@@ -361,5 +370,202 @@ strcpy(route, "W,W,W,W,E,E,E,E,W,W,W,SSSS");
     cout << "is an invalid route (" << error_description(result) << ")" << endl;
   cout << endl;
 
+#ifdef TUBE_EMBEDDED
+  cout << "===================== Embedded map =====================" << endl << endl;
+
+  /* this build carries map.txt, stations.txt and lines.txt in its tables,
+     so constant names are resolved by the compiler */
+  constexpr char oxford_circus = embedded_symbol_for("Oxford Circus");
+  static_assert(oxford_circus != ' ', "Oxford Circus is missing from the embedded map");
+  cout << "Oxford Circus has the symbol '" << oxford_circus << "' in the embedded map." << endl << endl;
+#else
+  cout << "================= Extended map format ==================" << endl << endl;
+
+  /* map_ext.txt is map.txt converted with TubeMap::save_extended(): station
+     cells hold '@' and their numeric IDs live in a side table */
+  TubeMap extended_map;
+  success = extended_map.load("map_ext.txt", "stations_ext.txt", "lines.txt");
+  assert(success);
+  cout << "Loaded extended map (height = " << extended_map.get_height() << ", width = " << extended_map.get_width() << ")." << endl << endl;
+
+  cout << "Oxford Circus has station ID " << extended_map.directory().find_station("Oxford Circus") << endl << endl;
+
+  strcpy(route, "S,SE,S,S,E,E,E,E,E,E,E,E,E,E,E");
+  cout << "Starting at Oxford Circus and taking the steps:" << endl;
+  cout << route << endl;
+  result = extended_map.validate_route("Oxford Circus", route, destination);
+  if (result >= 0)
+    cout << "is a valid route with " << result << " line change(s) ending at " << destination << "." << endl;
+  else 
+    cout << "is an invalid route (" << error_description(result) << ")" << endl;
+  cout << endl;
+
+  cout << "================ Station name completion ===============" << endl << endl;
+
+  PrefixIndex names;
+  success = names.build("stations.txt", "lines.txt");
+  assert(success);
+
+  const char *prefixes[] = {"ox", "BAKER", "vic", "st "};
+  Completion completions[PREFIX_INDEX_TOP_K];
+  for (int p = 0; p < 4; p++) {
+    int found = names.complete(prefixes[p], completions, 3);
+    cout << "Completions for '" << prefixes[p] << "':";
+    for (int n = 0; n < found; n++)
+      cout << (n ? ", " : " ") << completions[n].name;
+    cout << endl;
+  }
+  cout << endl;
+
+  cout << "=================== Multiple networks ==================" << endl << endl;
+
+  /* the two variants share map.txt's stations and lines, so the registry
+     keeps one copy of the name tables for both */
+  NetworkRegistry registry;
+  registry.load("tube", "map.txt", "stations.txt", "lines.txt");
+  registry.load("night tube", "map.txt", "stations.txt", "lines.txt");
+  registry.load("extended", "map_ext.txt", "stations_ext.txt", "lines.txt");
+  cout << "Loaded " << registry.network_count() << " networks sharing " << registry.table_count() << " name tables." << endl << endl;
+
+  shared_ptr<const TubeNetwork> night = registry.find("night tube");
+  assert(night);
+  strcpy(route, "W,W,W,W,E,E,E,E,W,W,W,W");
+  cout << "On the " << night->get_name() << ", starting at Victoria and taking the steps:" << endl;
+  cout << route << endl;
+  result = validate_route(*night, "Victoria", route, destination);
+  if (result >= 0)
+    cout << "is a valid route with " << result << " line change(s) ending at " << destination << "." << endl;
+  else 
+    cout << "is an invalid route (" << error_description(result) << ")" << endl;
+  cout << endl;
+
+  cout << "================ Nearest station to a cell =============" << endl << endl;
+
+  /* one search over the whole map answers every cell; station IDs from a
+     load_map() grid are the station symbols */
+  DistanceField field;
+  field.build(map, height, width);
+
+  int cell_rows[] = {3, 10, 20, 0};
+  int cell_cols[] = {20, 34, 26, 0};
+  StationId nearest[4];
+  uint32_t steps[4];
+  field.nearest_stations(cell_rows, cell_cols, 4, nearest, steps);
+  for (int n = 0; n < 4; n++) {
+    cout << "Cell (" << cell_rows[n] << "," << cell_cols[n] << ") is ";
+    if (nearest[n] == NO_STATION) {
+      cout << "not connected to any station." << endl;
+    } else {
+      get_station_name((char) nearest[n], destination);
+      cout << steps[n] << " step(s) along the track from " << destination << "." << endl;
+    }
+  }
+  cout << endl;
+
+  cout << "==================== Compressed map ====================" << endl << endl;
+
+  /* compress() swaps the grid for runs of one symbol per row; routes are
+     checked exactly as before */
+  size_t plain_bytes = extended_map.get_height() * extended_map.get_width();
+  success = extended_map.compress();
+  assert(success);
+  cout << "Compressed the extended map grid from " << plain_bytes << " to " << extended_map.grid_bytes() << " bytes." << endl << endl;
+
+  strcpy(route, "S,SE,S,S,E,E,E,E,E,E,E,E,E,E,E");
+  cout << "Starting at Oxford Circus and taking the steps:" << endl;
+  cout << route << endl;
+  result = extended_map.validate_route("Oxford Circus", route, destination);
+  if (result >= 0)
+    cout << "is a valid route with " << result << " line change(s) ending at " << destination << "." << endl;
+  else 
+    cout << "is an invalid route (" << error_description(result) << ")" << endl;
+  cout << endl;
+
+  cout << "================= Map viewport with route ==============" << endl << endl;
+
+  /* trace_route() records the cells a route visits; the renderer draws
+     them over a window of the map */
+  vector<uint32_t> path;
+  strcpy(route, "S,SE,S,S,E,E,E,E,E,E,E,E,E,E,E");
+  result = extended_map.trace_route("Oxford Circus", route, destination, path);
+  assert(result >= 0);
+
+  MapRenderer renderer;
+  Viewport view = {8, 20, 10, 40};
+  renderer.render(extended_map, view, &path);
+  renderer.write(cout);
+  cout << endl;
+
+  cout << "=================== Lines at a station =================" << endl << endl;
+
+  const char *junction_names[] = {"Oxford Circus", "Baker Street", "Bank"};
+  for (int n = 0; n < 3; n++) {
+    char symbols[256];
+    int count = extended_map.station_lines(extended_map.directory().find_station(junction_names[n]), symbols);
+    cout << junction_names[n] << " is served by";
+    for (int l = 0; l < count; l++)
+      cout << (l ? ", " : " ") << extended_map.directory().line_name(symbols[l]);
+    cout << "." << endl;
+  }
+  cout << endl;
+
+  cout << "================= Routes from station lists ============" << endl << endl;
+
+  StationGraph graph;
+  graph.build(extended_map);
+
+  const char *journey = "Paddington, Edgware Road (Circle Line), Baker Street";
+  string expanded;
+  int failed_hop;
+  result = graph.expand(journey, expanded, failed_hop);
+  cout << "The journey " << journey << endl;
+  if (result >= 0)
+    cout << "expands to " << expanded << " with " << result << " line change(s)." << endl;
+  else
+    cout << "cannot be expanded (" << expansion_error_description(result) << ")" << endl;
+  cout << endl;
+
+  cout << "================= Journey planning =====================" << endl << endl;
+
+  /* every network carries a planner; constraints are sets of stations and
+     lines to avoid, and step-free access from stations.txt */
+  shared_ptr<const TubeNetwork> tube = registry.find("tube");
+  PlanConstraints constraints;
+  for (int pass = 0; pass < 3; pass++) {
+    if (pass == 1)
+      constraints.avoid_line(get_line_symbol(*tube, "Northern Line"));
+    if (pass == 2)
+      constraints.step_free = true;
+    result = plan_journey(*tube, "Farringdon", "Bank", constraints, expanded);
+    cout << "Farringdon to Bank" << (pass == 0 ? "" : pass == 1 ? " avoiding the Northern Line" : ", also step-free") << ":" << endl;
+    if (result >= 0)
+      cout << expanded << " with " << result << " line change(s)." << endl;
+    else
+      cout << "no journey (" << expansion_error_description(result) << ")" << endl;
+    cout << endl;
+  }
+
+  cout << "================= Line connectivity ====================" << endl << endl;
+
+  /* components of the track are found as a network loads; the planner
+     uses them to turn down journeys between unconnected stations */
+  const LineConnectivity &components = tube->connectivity();
+  StationId farringdon = get_station_id(*tube, "Farringdon");
+  StationId liverpool_street = get_station_id(*tube, "Liverpool Street");
+  StationId bank = get_station_id(*tube, "Bank");
+  char circle = get_line_symbol(*tube, "Circle Line");
+  cout << "Farringdon and Bank are " << (components.stations_connected(farringdon, bank) ? "" : "not ")
+       << "connected." << endl;
+  cout << "Farringdon and Liverpool Street are " << (components.connected_on_line(farringdon, liverpool_street, circle) ? "" : "not ")
+       << "connected by the Circle Line." << endl;
+  cout << "Farringdon and Bank are " << (components.connected_on_line(farringdon, bank, circle) ? "" : "not ")
+       << "connected by the Circle Line." << endl;
+  cout << "The map has " << components.fragment_count() << " fragment(s)." << endl;
+  if (!components.report(cout))
+    cout << "Nothing is cut off from the rest of the map." << endl;
+  cout << endl;
+
+#endif
+
   return 0;
 }
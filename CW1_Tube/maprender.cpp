@@ -0,0 +1,92 @@
+#include <cstring>
+
+using namespace std;
+
+#include "maprender.h"
+
+
+/* internal helper which clips a viewport to the map and sizes the frame:
+   two header lines, then one line per row, each a row label, a space, the
+   cells and a newline */
+void MapRenderer::layout(int height, int width, const Viewport &view, int &top, int &left, int &rows, int &cols) {
+  top = view.top < 0 ? 0 : view.top;
+  left = view.left < 0 ? 0 : view.left;
+  rows = top >= height ? 0 : (view.rows < height - top ? view.rows : height - top);
+  cols = left >= width ? 0 : (view.cols < width - left ? view.cols : width - left);
+  if (rows < 0)
+    rows = 0;
+  if (cols < 0)
+    cols = 0;
+
+  label_width = 2;
+  for (int last = top + rows - 1; last >= 100; last /= 10)
+    label_width++;
+
+  size_t line = label_width + 1 + cols + 1;
+  frame.assign(line * (rows + 2), ' ');
+
+  /* column numbers: tens digit every tenth column, then the units digit */
+  char *tens = &frame[label_width + 1];
+  char *units = tens + line;
+  for (int c = 0; c < cols; c++) {
+    int column = left + c;
+    if (column && (column % 10) == 0)
+      tens[c] = '0' + (column / 10) % 10;
+    units[c] = '0' + column % 10;
+  }
+  tens[cols] = units[cols] = '\n';
+
+  for (int n = 0; n < rows; n++) {
+    char *label = row_cells(n, cols) - 1;
+    for (int r = top + n; r; r /= 10)
+      *--label = '0' + r % 10;
+    if (top + n == 0)
+      label[-1] = '0';
+    row_cells(n, cols)[cols] = '\n';
+  }
+}
+
+/* internal helper which returns where the cells of the n-th row go */
+char *MapRenderer::row_cells(int n, int cols) {
+  size_t line = label_width + 1 + cols + 1;
+  return &frame[line * (n + 2) + label_width + 1];
+}
+
+/* internal helper which marks the track cells of a route */
+void MapRenderer::draw_overlay(const TubeMap &map, const vector<uint32_t> &path,
+                               int top, int left, int rows, int cols) {
+  for (size_t n = 0; n < path.size(); n++) {
+    int r = path[n] / map.get_width(), c = path[n] % map.get_width();
+    if (r < top || r >= top + rows || c < left || c >= left + cols)
+      continue;
+    if (map.is_station(r, c))
+      continue;
+    row_cells(r - top, cols)[c - left] = ROUTE_MARK;
+  }
+}
+
+/* Function to format a viewport of a TubeMap */
+const string &MapRenderer::render(const TubeMap &map, const Viewport &view, const vector<uint32_t> *path) {
+  int top, left, rows, cols;
+  layout(map.get_height(), map.get_width(), view, top, left, rows, cols);
+  for (int n = 0; n < rows; n++)
+    map.copy_row(top + n, left, cols, row_cells(n, cols));
+  if (path)
+    draw_overlay(map, *path, top, left, rows, cols);
+  return frame;
+}
+
+/* Function to format a viewport of a map from load_map() */
+const string &MapRenderer::render(char **map, int height, int width, const Viewport &view) {
+  int top, left, rows, cols;
+  layout(height, width, view, top, left, rows, cols);
+  for (int n = 0; n < rows; n++)
+    memcpy(row_cells(n, cols), map[top + n] + left, cols);
+  return frame;
+}
+
+/* Function to write the frame with a single call */
+void MapRenderer::write(ostream &out) const {
+  out.write(frame.data(), frame.size());
+  out.flush();
+}
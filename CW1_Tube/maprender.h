@@ -0,0 +1,58 @@
+#ifndef MAPRENDER_H
+#define MAPRENDER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "tubemap.h"
+
+using namespace std;
+
+/* a window onto a map: rows [top, top + rows) and columns
+   [left, left + cols); windows reaching past the map are clipped */
+struct Viewport {
+  int top;
+  int left;
+  int rows;
+  int cols;
+};
+
+const Viewport WHOLE_MAP = {0, 0, 0x7FFFFFFF, 0x7FFFFFFF};
+
+/* symbol drawn over the track cells of a route overlay */
+const char ROUTE_MARK = '.';
+
+/* Formats part of a map, in the layout of print_map(), into one buffer
+   that is written out in a single call. The buffer is sized up front and
+   kept between frames, so paging through a large map allocates nothing
+   after the first frame. */
+class MapRenderer {
+private:
+  string frame;
+  int label_width;  // digits in the row numbers of the current frame
+
+  void layout(int height, int width, const Viewport &view, int &top, int &left, int &rows, int &cols);
+  char *row_cells(int n, int cols);
+  void draw_overlay(const TubeMap &map, const vector<uint32_t> &path, int top, int left, int rows, int cols);
+
+public:
+  MapRenderer() : label_width(2) {}
+
+  /* formats the cells of a TubeMap inside view. If path is given (cells as
+     filled in by TubeMap::trace_route()), its track cells are drawn as
+     ROUTE_MARK; stations keep their symbols. */
+  const string &render(const TubeMap &map, const Viewport &view, const vector<uint32_t> *path = NULL);
+
+  /* formats the cells of a map from load_map() inside view */
+  const string &render(char **map, int height, int width, const Viewport &view);
+
+  /* the last frame rendered */
+  const string &text() const { return frame; }
+
+  /* writes the last frame in one call */
+  void write(ostream &out) const;
+};
+
+#endif
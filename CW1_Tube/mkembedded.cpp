@@ -0,0 +1,129 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/* Build tool which turns a map, stations and lines file into a header of
+   constexpr tables (see tubeembedded.h):
+
+     mkembedded map.txt stations.txt lines.txt embedded_map.h
+
+   Rows are padded with spaces to the width of the map, as load_map() does.
+   Only the first station entry for each symbol is kept, as the station
+   directory does. */
+
+
+/* internal helper which reads one line, dropping any trailing '\r' */
+static bool read_line(istream &in, string &line) {
+  if (!getline(in, line))
+    return false;
+  if (!line.empty() && line[line.size() - 1] == '\r')
+    line.erase(line.size() - 1);
+  return true;
+}
+
+/* internal helper which writes text as a C string literal */
+static void write_literal(ostream &out, const string &text) {
+  out << '"';
+  for (size_t n = 0; n < text.size(); n++) {
+    if (text[n] == '"' || text[n] == '\\')
+      out << '\\';
+    out << text[n];
+  }
+  out << '"';
+}
+
+/* internal helper which writes a character as a C character literal */
+static void write_symbol(ostream &out, char symbol) {
+  out << '\'';
+  if (symbol == '\'' || symbol == '\\')
+    out << '\\';
+  out << symbol << '\'';
+}
+
+/* internal helper which writes a table of symbol/name entries */
+static void write_names(ostream &out, const char *table, const char *count,
+                        const vector<char> &symbols, const vector<string> &names) {
+  out << "constexpr int " << count << " = " << symbols.size() << ";\n";
+  out << "constexpr EmbeddedName " << table << "[" << count << " + 1] = {\n";
+  for (size_t n = 0; n < symbols.size(); n++) {
+    out << "  {";
+    write_symbol(out, symbols[n]);
+    out << ", ";
+    write_literal(out, names[n]);
+    out << "},\n";
+  }
+  out << "  {' ', \"\"}\n};\n\n";
+}
+
+int main(int argc, char **argv) {
+  if (argc != 5) {
+    cerr << "usage: mkembedded map stations lines output" << endl;
+    return 1;
+  }
+
+  ifstream in_map(argv[1]), in_stations(argv[2]), in_lines(argv[3]);
+  if (!in_map || !in_stations || !in_lines) {
+    cerr << "mkembedded: cannot read the map, stations or lines file" << endl;
+    return 1;
+  }
+
+  vector<string> rows;
+  string line;
+  size_t width = 0;
+  while (read_line(in_map, line)) {
+    rows.push_back(line);
+    if (line.size() > width)
+      width = line.size();
+  }
+  if (rows.empty()) {
+    cerr << "mkembedded: " << argv[1] << " is empty" << endl;
+    return 1;
+  }
+
+  vector<char> station_symbols, line_symbols;
+  vector<string> station_names, line_names;
+  bool seen[256] = {false};
+  while (read_line(in_stations, line)) {
+    if (line.size() < 2 || seen[(unsigned char) line[0]])
+      continue;
+    seen[(unsigned char) line[0]] = true;
+    station_symbols.push_back(line[0]);
+    station_names.push_back(line.substr(2, line.find('\t', 2) - 2)); // up to any attributes
+  }
+  while (read_line(in_lines, line)) {
+    if (line.size() < 2)
+      continue;
+    line_symbols.push_back(line[0]);
+    line_names.push_back(line.substr(2));
+  }
+
+  ofstream out(argv[4]);
+  out << "/* generated by mkembedded from " << argv[1] << ", " << argv[2] << " and "
+      << argv[3] << "; do not edit */\n\n";
+  out << "#define EMBEDDED_MAP_FILE ";
+  write_literal(out, argv[1]);
+  out << "\n\n";
+
+  out << "constexpr int EMBEDDED_MAP_HEIGHT = " << rows.size() << ";\n";
+  out << "constexpr int EMBEDDED_MAP_WIDTH = " << width << ";\n";
+  out << "constexpr const char *embedded_map_rows[EMBEDDED_MAP_HEIGHT] = {\n";
+  for (size_t r = 0; r < rows.size(); r++) {
+    out << "  ";
+    write_literal(out, rows[r] + string(width - rows[r].size(), ' '));
+    out << ",\n";
+  }
+  out << "};\n\n";
+
+  write_names(out, "embedded_stations", "EMBEDDED_STATION_COUNT", station_symbols, station_names);
+  write_names(out, "embedded_lines", "EMBEDDED_LINE_COUNT", line_symbols, line_names);
+
+  out.close();
+  if (!out) {
+    cerr << "mkembedded: cannot write " << argv[4] << endl;
+    return 1;
+  }
+  return 0;
+}
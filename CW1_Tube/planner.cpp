@@ -0,0 +1,227 @@
+#include <cstring>
+#include <queue>
+#include <algorithm>
+
+using namespace std;
+
+#include "planner.h"
+
+
+PlanConstraints::PlanConstraints() : step_free(false) {
+  memset(avoid_lines, 0, sizeof(avoid_lines));
+}
+
+void PlanConstraints::avoid_station(uint32_t index) {
+  if (index == NO_STATION)
+    return;
+  if (index / 64 >= avoid_stations.size())
+    avoid_stations.resize(index / 64 + 1, 0);
+  avoid_stations[index / 64] |= (uint64_t) 1 << (index % 64);
+}
+
+void PlanConstraints::avoid_line(char symbol) {
+  unsigned char s = symbol;
+  avoid_lines[s / 64] |= (uint64_t) 1 << (s % 64);
+}
+
+/* Function to encode the constraints for the cache; trailing empty words
+   of the station set are left out so equal sets give equal keys */
+string PlanConstraints::key() const {
+  size_t words = avoid_stations.size();
+  while (words > 0 && avoid_stations[words - 1] == 0)
+    words--;
+  string bytes(1, step_free ? '1' : '0');
+  bytes.append((const char *) avoid_lines, sizeof(avoid_lines));
+  if (words)
+    bytes.append((const char *) &avoid_stations[0], words * sizeof(uint64_t));
+  return bytes;
+}
+
+
+/* Function to index the station cells and lines of a graph */
+void JourneyPlanner::build(const StationGraph &station_graph, const LineConnectivity *components) {
+  graph = &station_graph;
+  connectivity = components;
+  const TubeMap &map = graph->get_map();
+  const StationDirectory &dir = map.directory();
+
+  node_at.clear();
+  node_cell.clear();
+  node_station.clear();
+  memset(line_slot, 0, sizeof(line_slot));
+  line_slots = 1; // slot 0: not yet on any line
+
+  for (int r = 0; r < map.get_height(); r++) {
+    for (int c = 0; c < map.get_width(); c++) {
+      if (!map.is_station(r, c))
+        continue;
+      uint32_t cell = r * map.get_width() + c;
+      node_at[cell] = node_cell.size();
+      node_cell.push_back(cell);
+      node_station.push_back(dir.station_index(map.station_at(r, c)));
+
+      uint32_t count;
+      const StationGraph::Edge *leaving = graph->edges_leaving(cell, count);
+      for (uint32_t n = 0; n < count; n++) {
+        unsigned char symbol = leaving[n].line;
+        if (!line_slot[symbol])
+          line_slot[symbol] = line_slots++;
+      }
+    }
+  }
+
+  step_free.assign(dir.station_count() / 64 + 1, 0);
+  for (uint32_t n = 0; n < dir.station_count(); n++)
+    if (dir.station_flags_at(n) & STATION_STEP_FREE)
+      step_free[n / 64] |= (uint64_t) 1 << (n % 64);
+
+  lock_guard<mutex> guard(cache_lock);
+  recent.clear();
+  cached.clear();
+}
+
+/* Function to plan a journey, answering repeated queries from the cache */
+int JourneyPlanner::plan(StationId from, StationId to, const PlanConstraints &constraints, string &route) const {
+  string key((const char *) &from, sizeof(from));
+  key.append((const char *) &to, sizeof(to));
+  key += constraints.key();
+
+  {
+    lock_guard<mutex> guard(cache_lock);
+    unordered_map<string, list<pair<string, Plan> >::iterator>::iterator it = cached.find(key);
+    if (it != cached.end()) {
+      recent.splice(recent.begin(), recent, it->second);
+      route = it->second->second.route;
+      hits++;
+      return it->second->second.result;
+    }
+    misses++;
+  }
+
+  int result = search(from, to, constraints, route);
+
+  lock_guard<mutex> guard(cache_lock);
+  if (!cached.count(key)) {
+    Plan planned = {result, route};
+    recent.push_front(make_pair(key, planned));
+    cached[key] = recent.begin();
+    if (recent.size() > PLAN_CACHE_SIZE) {
+      cached.erase(recent.back().first);
+      recent.pop_back();
+    }
+  }
+  return result;
+}
+
+/* Function to plan a journey between named stations */
+int JourneyPlanner::plan(const char from[], const char to[], const PlanConstraints &constraints, string &route) const {
+  if (!graph) {
+    route.clear();
+    return ERROR_UNKNOWN_STATION;
+  }
+  const StationDirectory &dir = graph->get_map().directory();
+  return plan(dir.find_station(from), dir.find_station(to), constraints, route);
+}
+
+/* internal helper which does the work of plan(). Search states are a
+   station cell together with the line the journey arrived on. */
+int JourneyPlanner::search(StationId from, StationId to, const PlanConstraints &constraints, string &route) const {
+  route.clear();
+  if (!graph)
+    return ERROR_UNKNOWN_STATION;
+  const TubeMap &map = graph->get_map();
+  const StationDirectory &dir = map.directory();
+
+  uint32_t from_index = dir.station_index(from), to_index = dir.station_index(to);
+  int r, c;
+  if (from_index == NO_STATION || to_index == NO_STATION || !map.station_position(from, r, c))
+    return ERROR_UNKNOWN_STATION;
+
+  bool from_step_free = (step_free[from_index / 64] >> (from_index % 64)) & 1;
+  bool to_step_free = (step_free[to_index / 64] >> (to_index % 64)) & 1;
+  if (constraints.avoids_station(from_index) || constraints.avoids_station(to_index)
+      || (constraints.step_free && (!from_step_free || !to_step_free)))
+    return ERROR_NO_ROUTE;
+
+  StationId end;
+  if (from == to)
+    return map.validate_steps(from, NULL, 0, end);
+  if (connectivity && !connectivity->stations_connected(from, to))
+    return ERROR_NO_ROUTE;
+
+  const uint32_t unreached = 0xFFFFFFFFu;
+  size_t states = node_cell.size() * line_slots;
+  vector<uint32_t> cost(states, unreached);
+  vector<uint32_t> came_from(states);
+  vector<const StationGraph::Edge *> came_by(states, NULL);
+
+  typedef pair<uint32_t, uint32_t> Entry; // cost, state
+  priority_queue<Entry, vector<Entry>, greater<Entry> > frontier;
+  uint32_t start = node_at.find(r * map.get_width() + c)->second * line_slots;
+  cost[start] = 0;
+  frontier.push(Entry(0, start));
+
+  uint32_t found = unreached;
+  while (!frontier.empty()) {
+    Entry top = frontier.top();
+    frontier.pop();
+    uint32_t state = top.second;
+    if (top.first > cost[state])
+      continue;
+    uint32_t node = state / line_slots, slot = state % line_slots;
+    if (node_station[node] == to_index) {
+      found = state;
+      break;
+    }
+
+    uint32_t here = node_station[node];
+    bool may_change = !constraints.step_free
+      || (here != NO_STATION && ((step_free[here / 64] >> (here % 64)) & 1));
+
+    uint32_t count;
+    const StationGraph::Edge *leaving = graph->edges_leaving(node_cell[node], count);
+    for (uint32_t n = 0; n < count; n++) {
+      const StationGraph::Edge &e = leaving[n];
+      if (e.line != JUNCTION_STATION && constraints.avoids_line(e.line))
+        continue;
+      uint32_t next = node_at.find(e.to_cell)->second;
+      if (constraints.avoids_station(node_station[next]))
+        continue;
+      uint32_t next_slot = line_slot[(unsigned char) e.line];
+      bool change = slot != 0 && slot != next_slot;
+      if (change && !may_change)
+        continue;
+
+      uint32_t next_cost = top.first + e.steps + (change ? PLAN_CHANGE_COST : 0);
+      uint32_t next_state = next * line_slots + next_slot;
+      if (next_cost < cost[next_state]) {
+        cost[next_state] = next_cost;
+        came_from[next_state] = state;
+        came_by[next_state] = &e;
+        frontier.push(Entry(next_cost, next_state));
+      }
+    }
+  }
+  if (found == unreached)
+    return ERROR_NO_ROUTE;
+
+  vector<const StationGraph::Edge *> hops;
+  for (uint32_t state = found; state != start; state = came_from[state])
+    hops.push_back(came_by[state]);
+  reverse(hops.begin(), hops.end());
+
+  vector<Direction> steps;
+  for (size_t n = 0; n < hops.size(); n++)
+    graph->append_edge(*hops[n], route, steps);
+  return map.validate_steps(from, steps.data(), steps.size(), end);
+}
+
+uint64_t JourneyPlanner::cache_hits() const {
+  lock_guard<mutex> guard(cache_lock);
+  return hits;
+}
+
+uint64_t JourneyPlanner::cache_misses() const {
+  lock_guard<mutex> guard(cache_lock);
+  return misses;
+}
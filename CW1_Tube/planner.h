@@ -0,0 +1,94 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+
+#include "tubemap.h"
+#include "stationgraph.h"
+#include "connectivity.h"
+
+using namespace std;
+
+/* steps of travel that one change of line is considered to be worth */
+#define PLAN_CHANGE_COST 8
+
+/* number of planned journeys kept for repeated queries */
+#define PLAN_CACHE_SIZE 4096
+
+/* What a journey must avoid. Stations are bits by their position in the
+   stations file (StationDirectory::station_index()), lines are bits by
+   symbol, so the planner tests them with a shift and a mask. */
+struct PlanConstraints {
+  vector<uint64_t> avoid_stations;
+  uint64_t avoid_lines[4];
+  bool step_free;   // board, change and alight only at step-free stations
+
+  PlanConstraints();
+
+  void avoid_station(uint32_t index);
+  void avoid_line(char symbol);
+
+  bool avoids_station(uint32_t index) const {
+    return index / 64 < avoid_stations.size() && ((avoid_stations[index / 64] >> (index % 64)) & 1);
+  }
+  bool avoids_line(char symbol) const {
+    unsigned char s = symbol;
+    return (avoid_lines[s / 64] >> (s % 64)) & 1;
+  }
+
+  /* the constraints as bytes, equal for equal constraints */
+  string key() const;
+};
+
+
+/* Journey planner over a StationGraph: a cheapest-path search in which a
+   step costs 1 and a change of line PLAN_CHANGE_COST, with avoided stations
+   and lines pruned as the search reaches them. Recent answers are cached by
+   journey and constraints, so a planner may be shared by many threads. */
+class JourneyPlanner {
+private:
+  const StationGraph *graph;
+  const LineConnectivity *connectivity;
+
+  unordered_map<uint32_t, uint32_t> node_at;  // station cell -> node
+  vector<uint32_t> node_cell;                 // node -> station cell
+  vector<uint32_t> node_station;              // node -> index in the stations file
+  vector<uint64_t> step_free;                 // bit per station index
+  uint8_t line_slot[256];                     // line symbol -> slot, 0 = none
+  int line_slots;
+
+  struct Plan {
+    int result;
+    string route;
+  };
+  mutable mutex cache_lock;
+  mutable list<pair<string, Plan> > recent;   // most recently used first
+  mutable unordered_map<string, list<pair<string, Plan> >::iterator> cached;
+  mutable uint64_t hits, misses;
+
+  int search(StationId from, StationId to, const PlanConstraints &constraints, string &route) const;
+
+public:
+  JourneyPlanner() : graph(NULL), connectivity(NULL), line_slots(1), hits(0), misses(0) {}
+
+  /* prepares to plan over a graph, which must outlive the planner, as
+     must the connectivity of its map if one is given: journeys between
+     stations it finds unconnected are then refused without a search */
+  void build(const StationGraph &graph, const LineConnectivity *connectivity = NULL);
+
+  /* plans the cheapest journey meeting the constraints and writes its
+     route; returns the validate_route() result for it, ERROR_UNKNOWN_STATION
+     or ERROR_NO_ROUTE */
+  int plan(StationId from, StationId to, const PlanConstraints &constraints, string &route) const;
+  int plan(const char from[], const char to[], const PlanConstraints &constraints, string &route) const;
+
+  uint64_t cache_hits() const;
+  uint64_t cache_misses() const;
+};
+
+#endif
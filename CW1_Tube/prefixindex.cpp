@@ -0,0 +1,143 @@
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+#include "prefixindex.h"
+#include "tubestats.h"
+
+
+/* internal helper which lower-cases one character */
+static char fold(char c) {
+  return (char) tolower((unsigned char) c);
+}
+
+/* Function to build the index from a directory: ranks the names, builds a
+   temporary pointer trie, then flattens it breadth first so every node's
+   children are contiguous */
+void PrefixIndex::build(const StationDirectory &dir) {
+  entries.clear();
+  nodes.clear();
+  top.clear();
+
+  for (uint32_t n = 0; n < dir.station_count(); n++) {
+    Entry e = { dir.station_name_at(n), false, dir.station_id_at(n) };
+    entries.push_back(e);
+  }
+  for (int symbol = 0; symbol < 256; symbol++) {
+    const char *name = dir.line_name((char) symbol);
+    if (name) {
+      Entry e = { name, true, (StationId) symbol };
+      entries.push_back(e);
+    }
+  }
+
+  struct ByRank {
+    bool operator()(const Entry &a, const Entry &b) const {
+      if (a.name.size() != b.name.size())
+        return a.name.size() < b.name.size();
+      if (a.is_line != b.is_line)
+        return !a.is_line;
+      return a.name < b.name;
+    }
+  };
+  stable_sort(entries.begin(), entries.end(), ByRank());
+
+  /* pointer trie; entries are inserted in rank order, so the first
+     PREFIX_INDEX_TOP_K to pass through a node are its best completions */
+  struct BuildNode {
+    map<char, uint32_t> children;
+    vector<uint32_t> best;
+  };
+  vector<BuildNode> trie(1);
+
+  for (uint32_t e = 0; e < entries.size(); e++) {
+    uint32_t at = 0;
+    if (trie[at].best.size() < PREFIX_INDEX_TOP_K)
+      trie[at].best.push_back(e);
+    for (size_t i = 0; i < entries[e].name.size(); i++) {
+      char label = fold(entries[e].name[i]);
+      map<char, uint32_t>::iterator it = trie[at].children.find(label);
+      if (it == trie[at].children.end()) {
+        trie[at].children[label] = trie.size();
+        at = trie.size();
+        trie.push_back(BuildNode());
+      } else {
+        at = it->second;
+      }
+      if (trie[at].best.size() < PREFIX_INDEX_TOP_K)
+        trie[at].best.push_back(e);
+    }
+  }
+
+  /* flatten: queue holds build-trie indices in the order they are laid out */
+  vector<uint32_t> order(1, 0);
+  vector<char> labels(1, '\0');
+  nodes.resize(trie.size());
+  for (size_t i = 0; i < order.size(); i++) {
+    BuildNode &b = trie[order[i]];
+    Node &n = nodes[i];
+    n.label = labels[i];
+    n.child_begin = order.size();
+    n.child_count = b.children.size();
+    n.top_begin = top.size();
+    n.top_count = b.best.size();
+    top.insert(top.end(), b.best.begin(), b.best.end());
+    for (map<char, uint32_t>::iterator it = b.children.begin(); it != b.children.end(); ++it) {
+      order.push_back(it->second);
+      labels.push_back(it->first);
+    }
+  }
+}
+
+/* Function to build the index straight from legacy stations and lines files */
+bool PrefixIndex::build(const char *stations_file, const char *lines_file) {
+  StationDirectory dir;
+  if (!dir.load(stations_file, lines_file, false))
+    return false;
+  build(dir);
+  return true;
+}
+
+/* internal helper which binary searches a node's children for a label,
+   returning the child's node index or -1 */
+int PrefixIndex::find_child(const Node &node, char label) const {
+  int lo = node.child_begin;
+  int hi = node.child_begin + node.child_count;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (nodes[mid].label < label)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  if (lo < (int) (node.child_begin + node.child_count) && nodes[lo].label == label)
+    return lo;
+  return -1;
+}
+
+/* Function to return the best k completions of a prefix */
+int PrefixIndex::complete(const char prefix[], Completion out[], int k) const {
+  TUBE_STATS_TIME(name_completion);
+  if (nodes.empty())
+    return 0;
+
+  int at = 0;
+  for (int i = 0; prefix[i] != '\0'; i++) {
+    at = find_child(nodes[at], fold(prefix[i]));
+    if (at < 0)
+      return 0;
+  }
+
+  const Node &node = nodes[at];
+  int count = min(k, (int) node.top_count);
+  for (int i = 0; i < count; i++) {
+    const Entry &e = entries[top[node.top_begin + i]];
+    out[i].name = e.name.c_str();
+    out[i].is_line = e.is_line;
+    out[i].id = e.id;
+  }
+  return count;
+}
@@ -0,0 +1,69 @@
+#ifndef PREFIXINDEX_H
+#define PREFIXINDEX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "tubemap.h"
+
+using namespace std;
+
+/* most completions a single query can return */
+#define PREFIX_INDEX_TOP_K 10
+
+/* one completion returned by PrefixIndex::complete() */
+struct Completion {
+  const char *name;   // station or line name as written in the files
+  bool is_line;       // true for a line, false for a station
+  StationId id;       // station ID, or the line symbol for a line
+};
+
+
+/* Case-insensitive prefix index over station and line names. Names are
+   stored in a trie flattened into arrays, with the children of each node
+   contiguous and sorted by label, and every node holding its best
+   PREFIX_INDEX_TOP_K completions. A query walks one node per prefix
+   character and copies the stored list, so its cost does not depend on how
+   many names share the prefix.
+
+   Completions are ranked shortest name first (an exact match therefore
+   always comes first), then stations before lines, then alphabetically. */
+class PrefixIndex {
+private:
+  struct Entry {
+    string name;
+    bool is_line;
+    StationId id;
+  };
+
+  struct Node {
+    uint32_t child_begin;  // index of first child in nodes
+    uint32_t top_begin;    // index of first completion in top
+    uint16_t child_count;
+    uint8_t top_count;
+    char label;            // lower-cased character leading to this node
+  };
+
+  vector<Entry> entries;   // in rank order
+  vector<Node> nodes;      // nodes[0] is the root
+  vector<uint32_t> top;    // entry indices, PREFIX_INDEX_TOP_K per node at most
+
+  int find_child(const Node &node, char label) const;
+
+public:
+  /* builds the index from a loaded directory */
+  void build(const StationDirectory &dir);
+
+  /* builds the index from legacy stations and lines files */
+  bool build(const char *stations_file, const char *lines_file);
+
+  /* fills out with up to k completions of prefix (compared without regard
+     to case) and returns how many were found */
+  int complete(const char prefix[], Completion out[], int k) const;
+
+  /* number of names held by the index */
+  int size() const { return entries.size(); }
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include <cstring>
+
+using namespace std;
+
+#include "rlegrid.h"
+
+
+/* Function to encode a row-major grid as runs */
+bool RleGrid::encode(const char cells[], int height, int width) {
+  if (height < 0 || width < 0 || width > RLE_GRID_MAX_WIDTH)
+    return false;
+
+  this->height = height;
+  this->width = width;
+  row_first.assign(1, 0);
+  run_end.clear();
+  run_symbol.clear();
+
+  for (int r = 0; r < height; r++) {
+    const char *row = cells + (size_t) r * width;
+    for (int c = 0; c < width; c++) {
+      if (c == 0 || row[c] != row[c - 1]) {
+        run_end.push_back(c + 1);
+        run_symbol.push_back(row[c]);
+      } else {
+        run_end.back()++;
+      }
+    }
+    row_first.push_back(run_symbol.size());
+  }
+
+  /* drop the spare capacity left by growing the vectors */
+  vector<uint16_t>(run_end).swap(run_end);
+  vector<char>(run_symbol).swap(run_symbol);
+  return true;
+}
+
+/* Function to expand part of a row, starting from the run holding left */
+void RleGrid::copy_row(int r, int left, int count, char out[]) const {
+  const uint16_t *first = &run_end[0] + row_first[r];
+  const uint16_t *last = &run_end[0] + row_first[r + 1];
+  uint32_t run = upper_bound(first, last, (uint16_t) left) - &run_end[0];
+  int c = left;
+  while (c < left + count) {
+    int stop = run_end[run] < left + count ? run_end[run] : left + count;
+    memset(out + (c - left), run_symbol[run], stop - c);
+    c = stop;
+    run++;
+  }
+}
+
+/* Function to find the first cell holding a symbol */
+bool RleGrid::find_symbol(char target, int &r, int &c) const {
+  for (r = 0; r < height; r++) {
+    for (uint32_t run = row_first[r]; run < row_first[r + 1]; run++) {
+      if (run_symbol[run] == target) {
+        c = run == row_first[r] ? 0 : run_end[run - 1];
+        return true;
+      }
+    }
+  }
+  r = c = -1;
+  return false;
+}
+
+size_t RleGrid::memory_size() const {
+  return row_first.size() * sizeof(uint32_t) + run_end.size() * sizeof(uint16_t)
+    + run_symbol.size() * sizeof(char);
+}
+
+
+RleGrid::RowReader::RowReader(const RleGrid &grid, int r)
+  : grid(grid), run(grid.row_first[r]), end(grid.row_first[r + 1]), column(0) {
+}
+
+/* Function to return the next run of the row; false once the row is done */
+bool RleGrid::RowReader::next(Run &out) {
+  if (run == end)
+    return false;
+  out.column = column;
+  out.length = grid.run_end[run] - column;
+  out.symbol = grid.run_symbol[run];
+  column = grid.run_end[run];
+  run++;
+  return true;
+}
@@ -0,0 +1,80 @@
+#ifndef RLEGRID_H
+#define RLEGRID_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+/* widest row a run-length grid can hold (run ends are 16-bit columns) */
+#define RLE_GRID_MAX_WIDTH 65535
+
+/* A map grid stored row by row as runs of one symbol. Tube maps are mostly
+   long horizontal stretches of track and spaces, so a row usually needs a
+   handful of runs where the plain grid needs one byte per cell. A cell is
+   found by a binary search over the runs of its row. */
+class RleGrid {
+private:
+  int height;
+  int width;
+  vector<uint32_t> row_first;   // index of each row's first run; height + 1 entries
+  vector<uint16_t> run_end;     // column just past the end of each run
+  vector<char> run_symbol;      // symbol of each run
+
+public:
+  RleGrid() : height(0), width(0) {}
+
+  /* encodes a row-major grid of height * width cells; returns false if the
+     grid is too wide to encode */
+  bool encode(const char cells[], int height, int width);
+
+  int get_height() const { return height; }
+  int get_width() const { return width; }
+
+  /* returns the symbol stored at (r, c) */
+  char cell(int r, int c) const {
+    const uint16_t *first = &run_end[0] + row_first[r];
+    const uint16_t *last = &run_end[0] + row_first[r + 1];
+    return run_symbol[upper_bound(first, last, (uint16_t) c) - &run_end[0]];
+  }
+
+  /* copies count cells of row r, starting at column left, into out */
+  void copy_row(int r, int left, int count, char out[]) const;
+
+  /* finds the first cell holding target in row-major order, skipping whole
+     runs; returns false with (-1, -1) if there is none */
+  bool find_symbol(char target, int &r, int &c) const;
+
+  /* number of runs, and bytes used by the encoded grid */
+  size_t run_count() const { return run_symbol.size(); }
+  size_t memory_size() const;
+
+  /* one run of a row, as returned by RowReader */
+  struct Run {
+    int column;   // first column of the run
+    int length;
+    char symbol;
+  };
+
+  /* streams the runs of one row from left to right:
+
+       RleGrid::RowReader reader(grid, r);
+       RleGrid::Run run;
+       while (reader.next(run))
+         ...                                                      */
+  class RowReader {
+  private:
+    const RleGrid &grid;
+    uint32_t run;
+    uint32_t end;
+    int column;
+
+  public:
+    RowReader(const RleGrid &grid, int r);
+    bool next(Run &out);
+  };
+};
+
+#endif
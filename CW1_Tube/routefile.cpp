@@ -0,0 +1,217 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+#include "routefile.h"
+#include "tubestats.h"
+
+
+/* internal helper which returns the number of bytes holding n packed steps */
+static size_t packed_bytes(uint32_t n) {
+  return ((size_t) n * 3 + 7) / 8;
+}
+
+/* internal helper which splits a text route into directions. Parsing stops
+   at the first token that is not a direction, which is reported through
+   trailing_invalid; a single trailing comma is ignored, as validate_route()
+   ignores it. */
+static void parse_route(const string &route, vector<Direction> &steps, bool &trailing_invalid) {
+  steps.clear();
+  trailing_invalid = false;
+  if (route.empty())
+    return;
+
+  size_t at = 0;
+  for (;;) {
+    size_t comma = route.find(',', at);
+    string token = route.substr(at, comma == string::npos ? string::npos : comma - at);
+    if (token.empty() && at == route.size() && at > 0)
+      return; // trailing comma
+    Direction d = string_to_direction(token.c_str());
+    if (d == INVALID_DIRECTION) {
+      trailing_invalid = true;
+      return;
+    }
+    steps.push_back(d);
+    if (comma == string::npos)
+      return;
+    at = comma + 1;
+  }
+}
+
+/* Function to convert a text route log into a binary route file */
+int convert_route_log(const TubeMap &map, const char *text_file, const char *binary_file) {
+  ifstream in(text_file);
+  if (!in)
+    return -1;
+
+  vector<uint64_t> offsets;
+  string records, line;
+  vector<Direction> steps;
+
+  while (getline(in, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+    if (line.empty())
+      continue;
+
+    size_t tab = line.find('\t');
+    string name = line.substr(0, tab);
+    string route = tab == string::npos ? string() : line.substr(tab + 1);
+
+    bool trailing_invalid;
+    parse_route(route, steps, trailing_invalid);
+
+    uint32_t start = map.directory().find_station(name.c_str());
+    uint32_t count = steps.size() | (trailing_invalid ? ROUTE_TRAILING_INVALID : 0);
+
+    offsets.push_back(records.size());
+    records.append((const char *) &start, sizeof(start));
+    records.append((const char *) &count, sizeof(count));
+
+    size_t packed_at = records.size();
+    records.append(packed_bytes(steps.size()), '\0');
+    for (size_t n = 0; n < steps.size(); n++) {
+      size_t bit = n * 3;
+      unsigned value = (unsigned) steps[n] << (bit & 7);
+      records[packed_at + bit / 8] |= (char) (value & 0xff);
+      if (value > 0xff)
+        records[packed_at + bit / 8 + 1] |= (char) (value >> 8);
+    }
+  }
+
+  RouteFileHeader header;
+  memcpy(header.magic, ROUTE_FILE_MAGIC, sizeof(header.magic));
+  header.version = ROUTE_FILE_VERSION;
+  header.route_count = offsets.size();
+
+  uint64_t base = sizeof(header) + offsets.size() * sizeof(uint64_t);
+  for (size_t n = 0; n < offsets.size(); n++)
+    offsets[n] += base;
+
+  ofstream out(binary_file, ios::binary);
+  if (!out)
+    return -1;
+  out.write((const char *) &header, sizeof(header));
+  if (!offsets.empty())
+    out.write((const char *) &offsets[0], offsets.size() * sizeof(uint64_t));
+  out.write(records.data(), records.size());
+  if (!out)
+    return -1;
+  return offsets.size();
+}
+
+
+RouteFile::RouteFile() : data(NULL), size(0), count(0) {}
+
+RouteFile::~RouteFile() {
+  close();
+}
+
+/* Function to map a route file and check that every record lies inside it */
+bool RouteFile::open(const char *filename) {
+  TUBE_STATS_TIME(route_file_open);
+  close();
+
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat info;
+  if (fstat(fd, &info) < 0 || (size_t) info.st_size < sizeof(RouteFileHeader)) {
+    ::close(fd);
+    return false;
+  }
+  void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    return false;
+  madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+
+  data = (const unsigned char *) mapped;
+  size = info.st_size;
+
+  RouteFileHeader header;
+  memcpy(&header, data, sizeof(header));
+  if (memcmp(header.magic, ROUTE_FILE_MAGIC, sizeof(header.magic))
+      || header.version != ROUTE_FILE_VERSION
+      || (size - sizeof(header)) / sizeof(uint64_t) < header.route_count) {
+    close();
+    return false;
+  }
+  count = header.route_count;
+
+  for (uint32_t i = 0; i < count; i++) {
+    uint64_t offset;
+    memcpy(&offset, data + sizeof(header) + i * sizeof(uint64_t), sizeof(offset));
+    uint32_t steps;
+    if (offset > size || size - offset < 2 * sizeof(uint32_t)) {
+      close();
+      return false;
+    }
+    memcpy(&steps, data + offset + sizeof(uint32_t), sizeof(steps));
+    if (size - offset - 2 * sizeof(uint32_t) < packed_bytes(steps & ~ROUTE_TRAILING_INVALID)) {
+      close();
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Function to unmap the file */
+void RouteFile::close() {
+  if (data)
+    munmap((void *) data, size);
+  data = NULL;
+  size = 0;
+  count = 0;
+}
+
+/* internal helper which returns where record i starts */
+static const unsigned char *record(const unsigned char *data, uint32_t i) {
+  uint64_t offset;
+  memcpy(&offset, data + sizeof(RouteFileHeader) + i * sizeof(uint64_t), sizeof(offset));
+  return data + offset;
+}
+
+/* Function to return the start station of a route */
+StationId RouteFile::start(uint32_t i) const {
+  StationId id;
+  memcpy(&id, record(data, i), sizeof(id));
+  return id;
+}
+
+/* Function to unpack the directions of a route */
+uint32_t RouteFile::steps(uint32_t i, vector<Direction> &steps, bool &trailing_invalid) const {
+  TUBE_STATS_TIME(route_decode);
+  const unsigned char *at = record(data, i);
+  uint32_t n;
+  memcpy(&n, at + sizeof(StationId), sizeof(n));
+  trailing_invalid = (n & ROUTE_TRAILING_INVALID) != 0;
+  n &= ~ROUTE_TRAILING_INVALID;
+
+  const unsigned char *packed = at + sizeof(StationId) + sizeof(n);
+  steps.resize(n);
+  for (uint32_t s = 0; s < n; s++) {
+    size_t bit = (size_t) s * 3;
+    unsigned value = packed[bit / 8] >> (bit & 7);
+    if ((bit & 7) > 5)
+      value |= packed[bit / 8 + 1] << (8 - (bit & 7));
+    steps[s] = (Direction) (value & 7);
+  }
+  return n;
+}
+
+/* Function to validate one route of the file against a map */
+int RouteFile::validate(const TubeMap &map, uint32_t i, vector<Direction> &scratch, StationId &end) const {
+  bool trailing_invalid;
+  uint32_t n = steps(i, scratch, trailing_invalid);
+  return map.validate_steps(start(i), n ? &scratch[0] : NULL, n, end, trailing_invalid);
+}
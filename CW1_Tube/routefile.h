@@ -0,0 +1,77 @@
+#ifndef ROUTEFILE_H
+#define ROUTEFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "tube.h"
+#include "tubemap.h"
+
+using namespace std;
+
+/* Binary container for bulk routes, laid out so it can be validated straight
+   from an mmap:
+
+     RouteFileHeader
+     uint64 offsets[route_count]   byte offset of each record from the start
+                                   of the file
+     records, each:
+       uint32 start station ID     (NO_STATION if the name was unknown)
+       uint32 step_count           bit 31 set if the text route continued
+                                   with an invalid direction after these steps
+       packed steps                3 bits per Direction, least significant
+                                   bits first, padded to a whole byte
+
+   A step costs 3 bits instead of the 2-3 bytes of "NE," in a text log. */
+
+#define ROUTE_FILE_MAGIC "TUBERTE1"
+#define ROUTE_FILE_VERSION 1
+
+/* set in a record's step_count when the route ends in an invalid direction */
+#define ROUTE_TRAILING_INVALID 0x80000000u
+
+struct RouteFileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t route_count;
+};
+
+/* Converts a text route log to the binary format. Each line of the log is
+   "<start station>\t<route>", the route written as for validate_route().
+   Station names are resolved through the map's directory. Returns the number
+   of routes written, or -1 if either file cannot be opened. */
+int convert_route_log(const TubeMap &map, const char *text_file, const char *binary_file);
+
+
+/* Read-only view of a binary route file mapped into memory. */
+class RouteFile {
+private:
+  const unsigned char *data;
+  size_t size;
+  uint32_t count;
+
+public:
+  RouteFile();
+  ~RouteFile();
+
+  /* maps a file, checking its header and offset index; returns false if it
+     is not a well-formed route file */
+  bool open(const char *filename);
+  void close();
+
+  uint32_t route_count() const { return count; }
+
+  /* start station of route i */
+  StationId start(uint32_t i) const;
+
+  /* unpacks route i into steps and returns its step count; trailing_invalid
+     reports whether the text route went on with an invalid direction */
+  uint32_t steps(uint32_t i, vector<Direction> &steps, bool &trailing_invalid) const;
+
+  /* validates route i against a map, with the result codes of
+     validate_route(); end receives the final station of a valid route */
+  int validate(const TubeMap &map, uint32_t i, vector<Direction> &scratch, StationId &end) const;
+};
+
+#endif
@@ -0,0 +1,217 @@
+#include <cstring>
+
+using namespace std;
+
+#include "stationgraph.h"
+
+
+/* route text and offsets of each Direction */
+static const char *direction_text[8] = {"N", "S", "W", "E", "NE", "NW", "SE", "SW"};
+static const int direction_dr[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+static const int direction_dc[8] = {0, 0, -1, 1, 1, -1, 1, -1};
+
+
+/* Function to build the graph. From each station cell, each line leaving
+   it is traced by a breadth first search over cells of that line, stopping
+   at station cells; every station reached gives an edge along the
+   shortest stretch of track to it. */
+void StationGraph::build(const TubeMap &tube_map) {
+  map = &tube_map;
+  edges.clear();
+  edges_from.clear();
+  route_text.clear();
+  route_steps.clear();
+
+  int height = map->get_height(), width = map->get_width();
+  vector<uint32_t> seen((size_t) height * width, 0);
+  vector<uint8_t> came_by((size_t) height * width);   // Direction into each cell
+  vector<uint32_t> queue;
+  vector<uint8_t> path;
+  uint32_t stamp = 0;
+
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++) {
+      if (!map->is_station(r, c))
+        continue;
+      uint32_t from = r * width + c;
+      uint32_t first_edge = edges.size();
+
+      for (int d = N; d < INVALID_DIRECTION; d++) {
+        int nr = r + direction_dr[d], nc = c + direction_dc[d];
+        if (nr < 0 || nc < 0 || nr >= height || nc >= width || map->cell(nr, nc) == ' ')
+          continue;
+
+        char line = map->is_station(nr, nc) ? JUNCTION_STATION : map->cell(nr, nc);
+        stamp++;
+        seen[from] = stamp;
+        seen[nr * width + nc] = stamp;
+        came_by[nr * width + nc] = d;
+        queue.assign(1, nr * width + nc);
+
+        for (size_t head = 0; head < queue.size(); head++) {
+          uint32_t at = queue[head];
+          int ar = at / width, ac = at % width;
+
+          if (map->is_station(ar, ac)) {
+            /* walk back to the start to recover the steps taken */
+            path.clear();
+            for (uint32_t back = at; back != from; ) {
+              int dir = came_by[back];
+              path.push_back(dir);
+              back = (back / width - direction_dr[dir]) * width + (back % width - direction_dc[dir]);
+            }
+
+            Edge e;
+            e.from_cell = from;
+            e.to_cell = at;
+            e.to = map->station_at(ar, ac);
+            e.line = line;
+            e.text = route_text.size();
+            e.first_step = route_steps.size();
+            e.steps = path.size();
+            for (size_t n = path.size(); n-- > 0; ) {
+              if (n + 1 < path.size())
+                route_text += ',';
+              route_text += direction_text[path[n]];
+              route_steps.push_back((Direction) path[n]);
+            }
+            e.length = route_text.size() - e.text;
+            edges.push_back(e);
+            continue; // the line ends at a station
+          }
+
+          for (int step = N; step < INVALID_DIRECTION; step++) {
+            int sr = ar + direction_dr[step], sc = ac + direction_dc[step];
+            if (sr < 0 || sc < 0 || sr >= height || sc >= width)
+              continue;
+            uint32_t next = sr * width + sc;
+            if (seen[next] == stamp)
+              continue;
+            if (!map->is_station(sr, sc) && map->cell(sr, sc) != line)
+              continue;
+            seen[next] = stamp;
+            came_by[next] = step;
+            queue.push_back(next);
+          }
+        }
+      }
+
+      if (edges.size() > first_edge)
+        edges_from[from] = make_pair(first_edge, (uint32_t) edges.size());
+    }
+  }
+}
+
+/* Function to return the edges leaving a station cell */
+const StationGraph::Edge *StationGraph::edges_leaving(uint32_t cell, uint32_t &count) const {
+  unordered_map<uint32_t, pair<uint32_t, uint32_t> >::const_iterator it = edges_from.find(cell);
+  if (it == edges_from.end()) {
+    count = 0;
+    return NULL;
+  }
+  count = it->second.second - it->second.first;
+  return &edges[it->second.first];
+}
+
+/* Function to append an edge's precomputed route text and steps */
+void StationGraph::append_edge(const Edge &e, string &route, vector<Direction> &steps) const {
+  if (!route.empty())
+    route += ',';
+  route.append(route_text, e.text, e.length);
+  steps.insert(steps.end(), route_steps.begin() + e.first_step, route_steps.begin() + e.first_step + e.steps);
+}
+
+/* internal helper which picks the edge for one hop: the shortest, and of
+   equally short edges one on the line already being travelled */
+const StationGraph::Edge *StationGraph::choose_edge(uint32_t from_cell, StationId to, char previous_line) const {
+  uint32_t count;
+  const Edge *leaving = edges_leaving(from_cell, count);
+
+  const Edge *best = NULL;
+  for (uint32_t n = 0; n < count; n++) {
+    const Edge &e = leaving[n];
+    if (e.to != to)
+      continue;
+    if (!best || e.steps < best->steps
+        || (e.steps == best->steps && e.line == previous_line && best->line != previous_line))
+      best = &e;
+  }
+  return best;
+}
+
+/* Function to expand a sequence of station IDs into a checked route */
+int StationGraph::expand(const StationId stations[], int count, string &route, int &failed_hop) const {
+  route.clear();
+  failed_hop = -1;
+
+  int r, c;
+  if (count <= 0 || !map || !map->station_position(stations[0], r, c)) {
+    failed_hop = 0;
+    return ERROR_UNKNOWN_STATION;
+  }
+
+  vector<Direction> steps;
+  uint32_t at = r * map->get_width() + c;
+  char line = JUNCTION_STATION;
+  for (int n = 1; n < count; n++) {
+    if (stations[n] == stations[n - 1])
+      continue; // staying put needs no steps
+    const Edge *e = choose_edge(at, stations[n], line);
+    if (!e) {
+      failed_hop = n;
+      return map->station_position(stations[n], r, c) ? ERROR_STATIONS_NOT_CONNECTED : ERROR_UNKNOWN_STATION;
+    }
+    append_edge(*e, route, steps);
+    at = e->to_cell;
+    line = e->line;
+  }
+
+  StationId end;
+  return map->validate_steps(stations[0], steps.data(), steps.size(), end);
+}
+
+/* Function to expand a comma-separated list of station names */
+int StationGraph::expand(const char sequence[], string &route, int &failed_hop) const {
+  vector<StationId> stations;
+  const char *p = sequence;
+  for (;;) {
+    while (*p == ' ')
+      p++;
+    const char *stop = strchr(p, ',');
+    size_t length = stop ? (size_t) (stop - p) : strlen(p);
+    while (length > 0 && p[length - 1] == ' ')
+      length--;
+
+    StationId id = map ? map->directory().find_station(string(p, length).c_str()) : NO_STATION;
+    if (id == NO_STATION) {
+      route.clear();
+      failed_hop = stations.size();
+      return ERROR_UNKNOWN_STATION;
+    }
+    stations.push_back(id);
+
+    if (!stop)
+      break;
+    p = stop + 1;
+  }
+  return expand(stations.data(), stations.size(), route, failed_hop);
+}
+
+/* Function to expand many sequences */
+void StationGraph::expand_all(const char *const sequences[], size_t count, string routes[], int results[]) const {
+  int failed_hop;
+  for (size_t n = 0; n < count; n++)
+    results[n] = expand(sequences[n], routes[n], failed_hop);
+}
+
+const char *expansion_error_description(int code) {
+  switch (code) {
+  case ERROR_UNKNOWN_STATION:
+    return "Unknown station";
+  case ERROR_STATIONS_NOT_CONNECTED:
+    return "No track between consecutive stations";
+  case ERROR_NO_ROUTE:
+    return "No route meets the constraints";
+  }
+  return error_description(code);
+}
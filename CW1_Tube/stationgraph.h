@@ -0,0 +1,84 @@
+#ifndef STATIONGRAPH_H
+#define STATIONGRAPH_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "tubemap.h"
+
+using namespace std;
+
+/* result of expanding a station sequence that is not a valid journey */
+#define ERROR_UNKNOWN_STATION -8
+#define ERROR_STATIONS_NOT_CONNECTED -9
+
+/* result of planning a journey when no route meets the constraints */
+#define ERROR_NO_ROUTE -10
+
+/* The stations of a map joined by the track between them. Every edge
+   follows one line from a station cell to the next station cell along it,
+   and carries its route text ("E,E,SE,...") precomputed, so turning a
+   station sequence into a route is one copy per hop. */
+class StationGraph {
+public:
+  struct Edge {
+    uint32_t from_cell;     // row * width + column of both ends
+    uint32_t to_cell;
+    StationId to;
+    char line;              // symbol of the track followed
+    uint32_t text;          // offset of the route text in route_text
+    uint32_t length;        // length of the route text
+    uint32_t first_step;    // offset of the steps in route_steps
+    uint32_t steps;
+  };
+
+private:
+  vector<Edge> edges;       // sorted by from_cell
+  unordered_map<uint32_t, pair<uint32_t, uint32_t> > edges_from; // cell -> [first, last)
+  string route_text;        // every edge's route text, back to back
+  vector<Direction> route_steps; // and the same steps as directions
+
+  const TubeMap *map;
+
+  const Edge *choose_edge(uint32_t from_cell, StationId to, char previous_line) const;
+
+public:
+  StationGraph() : map(NULL) {}
+
+  /* traces every line leaving every station cell of a map; the map must
+     outlive the graph */
+  void build(const TubeMap &map);
+
+  size_t edge_count() const { return edges.size(); }
+  const TubeMap &get_map() const { return *map; }
+
+  /* returns the edges leaving a station cell, setting count (0 if none) */
+  const Edge *edges_leaving(uint32_t cell, uint32_t &count) const;
+
+  /* appends an edge's route text, after a comma if route is not empty, and
+     its steps */
+  void append_edge(const Edge &e, string &route, vector<Direction> &steps) const;
+
+  /* expands a sequence of stations into the route visiting them in turn,
+     taking the shortest edge for each hop and keeping to the previous
+     hop's line between equally short ones. The route is then checked with
+     validate_route(); returns its result, ERROR_UNKNOWN_STATION or
+     ERROR_STATIONS_NOT_CONNECTED (with failed_hop set to the index of the
+     station that could not be reached). */
+  int expand(const StationId stations[], int count, string &route, int &failed_hop) const;
+
+  /* the same for a comma-separated list of station names, such as
+     "Paddington, Baker Street, Euston" */
+  int expand(const char sequence[], string &route, int &failed_hop) const;
+
+  /* expands count sequences, filling routes and results */
+  void expand_all(const char *const sequences[], size_t count, string routes[], int results[]) const;
+};
+
+/* returns a description of the errors above, or of a validate_route() code */
+const char *expansion_error_description(int code);
+
+#endif
@@ -9,6 +9,12 @@
 using namespace std;
 
 #include "tube.h"
+#include "tubemap.h"
+#include "maprender.h"
+#include "tubestats.h"
+#ifdef TUBE_EMBEDDED
+#include "tubeembedded.h"
+#endif
 
 
 /* You are pre-supplied with the functions below. Add your own 
@@ -55,6 +61,19 @@ bool get_map_dimensions(const char *filename, int &height, int &width) {
 
 /* pre-supplied function to load a tube map from a file*/
 char **load_map(const char *filename, int &height, int &width) {
+  TUBE_STATS_TIME(load_map);
+
+#ifdef TUBE_EMBEDDED
+  /* the compiled-in map is copied rather than read */
+  if (!strcmp(filename, EMBEDDED_MAP_FILE)) {
+    height = EMBEDDED_MAP_HEIGHT;
+    width = EMBEDDED_MAP_WIDTH;
+    char **e = allocate_2D_array(height, width);
+    for (int r = 0; r < height; r++)
+      memcpy(e[r], embedded_map_rows[r], width);
+    return e;
+  }
+#endif
 
   bool success = get_map_dimensions(filename, height, width);
   
@@ -80,25 +99,9 @@ char **load_map(const char *filename, int &height, int &width) {
 
 /* pre-supplied function to print the tube map */
 void print_map(char **m, int height, int width) {
-  cout << setw(2) << " " << " ";
-  for (int c=0; c<width; c++)
-    if (c && (c % 10) == 0) 
-      cout << c/10;
-    else
-      cout << " ";
-  cout << endl;
-
-  cout << setw(2) << " " << " ";
-  for (int c=0; c<width; c++)
-    cout << (c % 10);
-  cout << endl;
-
-  for (int r=0; r<height; r++) {
-    cout << setw(2) << r << " ";    
-    for (int c=0; c<width; c++) 
-      cout << m[r][c];
-    cout << endl;
-  }
+  MapRenderer renderer;
+  renderer.render(m, height, width, WHOLE_MAP);
+  renderer.write(cout);
 }
 
 /* pre-supplied helper function to report the errors encountered in Question 3 */
@@ -151,52 +154,42 @@ bool get_symbol_position(char **map, int height, int width, char target, int &r,
 }
 
 
+#ifndef TUBE_EMBEDDED
+/* internal helper which returns the station and line directory; the files
+   are read once, on first use, rather than on every lookup */
+static const StationDirectory &legacy_directory() {
+  struct LegacyDirectory {
+    StationDirectory dir;
+    LegacyDirectory() { dir.load("stations.txt", "lines.txt", false); }
+  };
+  static LegacyDirectory legacy;
+  return legacy.dir;
+}
+#endif
+
 /* Function to return the symbol for a given station or line,
    if none exist return ' ' */
 char get_symbol_for_station_or_line(const char name[]) {
 
-  ifstream in_stations, in_lines;
-
-  const char stations_file[] = "stations.txt";
-  const char lines_file[] = "lines.txt";
-
-  in_stations.open(stations_file);
-  in_lines.open(lines_file);
-
-  char c;
-  char a[80];
-
   if (!strcmp(name, "")) { // catches if an empty string has been passed
-    return c = ' ';
+    return ' ';
   }
 
-  /* First, check for the symbol in the stations file. */
-  while (in_stations) {
-    in_stations.get(c);
-    in_stations.get();
-    in_stations.getline(a, 80);
-
-    if (!strcmp(a,name)) {
-      return c;
-    }
-  }
-  /* Now, check for the symbol in the lines file. */
-  while (in_lines) {
-    in_lines.get(c);
-    in_lines.get();
-    in_lines.getline(a, 80);
-
-    if (!strcmp(a,name)) {
-      return c;
-    }
-  }
-  return c = ' ';
+  /* First, check for the symbol among the stations, then among the lines. */
+#ifdef TUBE_EMBEDDED
+  return embedded_symbol_for(name);
+#else
+  StationId id = legacy_directory().find_station(name);
+  if (id != NO_STATION)
+    return (char) id;
+  return legacy_directory().find_line(name);
+#endif
 }
  
 
-/* Function to check if route valid */
-
-int validate_route(char **map, int height, int width, const char start[], char route[], char end[]) {
+/* internal helper which checks a route for validate_route(), counting the
+   steps it takes */
+static int check_route(char **map, int height, int width, const char start[], char route[], char end[], int &steps) {
 
   /* These will allow us to keep track of previous two steps */
   int r1 = 0;
@@ -231,6 +224,7 @@ int validate_route(char **map, int height, int width, const char start[], char r
     c1 = c2;
     r2 = r3;
     c2 = c3;
+    steps++;
 
     int count = 0;
     while (isalnum(route[i])) { //This will read the string until a comma, 
@@ -310,24 +304,25 @@ int validate_route(char **map, int height, int width, const char start[], char r
 
 }
 
+/* Function to check if route valid */
+
+int validate_route(char **map, int height, int width, const char start[], char route[], char end[]) {
+  TUBE_STATS_TIME(validate_route);
+  int steps = 0;
+  int result = check_route(map, height, width, start, route, end, steps);
+  TUBE_STATS_RESULT(result);
+  TUBE_STATS_STEPS(steps);
+  return result;
+}
+
 /* Function to return the station name for a given station symbol, if none exist,
    do not modify string. */
 void get_station_name(char c, char name[]) {
-  ifstream in_stations;
-  const char stations_file[] = "stations.txt";
-  in_stations.open(stations_file);
-
-  char b;
-  char a[200];
-
-  while (in_stations) {
-    in_stations.get(b);
-    in_stations.get();
-    in_stations.getline(a, 200);
-
-    if (b == c) {
-      strcpy(name,a);
-    }
-  }
-
+#ifdef TUBE_EMBEDDED
+  const char *found = embedded_station_name(c);
+#else
+  const char *found = legacy_directory().station_name((unsigned char) c);
+#endif
+  if (found)
+    strcpy(name, found);
 }
@@ -1,3 +1,6 @@
+#ifndef TUBE_H
+#define TUBE_H
+
 enum Direction {N, S, W, E, NE, NW, SE, SW, INVALID_DIRECTION};
 
 /* error codes for Question 3 */
@@ -32,3 +35,5 @@ int validate_route(char **map, int height, int width, const char start[], char r
 
 /* Function to return station name from a character */
 void get_station_name(char c, char name[]);
+
+#endif
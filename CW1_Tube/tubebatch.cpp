@@ -0,0 +1,127 @@
+/* tubebatch: bulk route validation.
+
+   usage: tubebatch convert <log.txt> <routes.bin> [map stations lines]
+          tubebatch validate <routes.bin> [map stations lines]
+          tubebatch validate-text <log.txt> [map stations lines]
+
+   convert turns a text route log ("<start station>\t<route>" per line) into
+   the binary format of routefile.h. validate checks every route of a binary
+   file straight from its mmap; validate-text does the same for a text log.
+   Both print "<route number>\t<result>\t<end station>" per route and a
+   count of each result code at the end.
+
+   With --stats as the last argument, the engine's counters and histograms
+   are written to stderr as JSON when the run finishes. */
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <string>
+#include <map>
+
+using namespace std;
+
+#include "tube.h"
+#include "tubemap.h"
+#include "routefile.h"
+#include "tubestats.h"
+
+/* internal helper which prints one result line */
+static void print_result(uint32_t n, int result, const char *end) {
+  cout << n << '\t' << result << '\t' << (result >= 0 && end ? end : "") << '\n';
+}
+
+/* internal helper which prints how often each result code came up */
+static void print_summary(const map<int, uint32_t> &results) {
+  for (map<int, uint32_t>::const_iterator it = results.begin(); it != results.end(); ++it) {
+    cout << "# " << it->second << " route(s): ";
+    if (it->first >= 0)
+      cout << "valid with " << it->first << " line change(s)";
+    else
+      cout << error_description(it->first);
+    cout << '\n';
+  }
+}
+
+int main(int argc, char **argv) {
+  bool stats = argc > 1 && !strcmp(argv[argc - 1], "--stats");
+  if (stats)
+    argc--;
+
+  if (argc < 3) {
+    cerr << "usage: tubebatch convert <log.txt> <routes.bin> [map stations lines]" << endl
+         << "       tubebatch validate <routes.bin> [map stations lines]" << endl
+         << "       tubebatch validate-text <log.txt> [map stations lines]" << endl;
+    return 1;
+  }
+
+  const char *command = argv[1];
+  int files_at = !strcmp(command, "convert") ? 4 : 3;
+  const char *files[3] = {"map.txt", "stations.txt", "lines.txt"};
+  for (int n = 0; n < 3 && files_at + n < argc; n++)
+    files[n] = argv[files_at + n];
+
+  TubeMap tube;
+  if (!tube.load(files[0], files[1], files[2])) {
+    cerr << "tubebatch: cannot load " << files[0] << endl;
+    return 1;
+  }
+
+  map<int, uint32_t> results;
+
+  if (!strcmp(command, "convert") && argc >= 4) {
+    int written = convert_route_log(tube, argv[2], argv[3]);
+    if (written < 0) {
+      cerr << "tubebatch: cannot convert " << argv[2] << endl;
+      return 1;
+    }
+    cout << "# " << written << " route(s) written to " << argv[3] << endl;
+
+  } else if (!strcmp(command, "validate")) {
+    RouteFile routes;
+    if (!routes.open(argv[2])) {
+      cerr << "tubebatch: " << argv[2] << " is not a route file" << endl;
+      return 1;
+    }
+    vector<Direction> scratch;
+    for (uint32_t n = 0; n < routes.route_count(); n++) {
+      StationId end;
+      int result = routes.validate(tube, n, scratch, end);
+      print_result(n, result, tube.directory().station_name(end));
+      results[result]++;
+    }
+    print_summary(results);
+
+  } else if (!strcmp(command, "validate-text")) {
+    ifstream in(argv[2]);
+    if (!in) {
+      cerr << "tubebatch: cannot open " << argv[2] << endl;
+      return 1;
+    }
+    string line;
+    uint32_t n = 0;
+    string end;
+    while (getline(in, line)) {
+      if (!line.empty() && line[line.size() - 1] == '\r')
+        line.erase(line.size() - 1);
+      if (line.empty())
+        continue;
+      size_t tab = line.find('\t');
+      string name = line.substr(0, tab);
+      string route = tab == string::npos ? string() : line.substr(tab + 1);
+      end.clear();
+      int result = tube.validate_route(name.c_str(), route.c_str(), end);
+      print_result(n++, result, end.c_str());
+      results[result]++;
+    }
+    print_summary(results);
+
+  } else {
+    cerr << "tubebatch: unknown command " << command << endl;
+    return 1;
+  }
+
+  if (stats)
+    cerr << tube_stats_json() << endl;
+  return 0;
+}
@@ -0,0 +1,588 @@
+/* tubed: long-running tube query daemon.
+
+   Loads a map with its stations and lines once, then answers validate,
+   plan and lookup requests (see tubeproto.h) over a Unix domain socket.
+   A single thread polls the listening socket and all clients; requests
+   arriving within BATCH_WINDOW_US of the first pending one are handed to
+   the worker threads together. Client sockets are non-blocking: a worker
+   sends what the socket will take at once and leaves the rest in the
+   connection's output buffer for the poll loop to flush, so a client that
+   stops reading never holds up a worker.
+
+   The map lives in a LiveTubeMap: an OP_RELOAD request builds a new map
+   and swaps it in while the other workers keep answering queries.
+
+   usage: tubed [-s socket] [-t threads] [map stations lines] */
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <csignal>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+
+#include "tube.h"
+#include "tubenetwork.h"
+#include "livemap.h"
+#include "tubeproto.h"
+#include "tubestats.h"
+
+/* requests arriving within this window of the first pending request are
+   dispatched to the workers as one batch */
+#define BATCH_WINDOW_US 200
+
+/* a batch is dispatched early once it holds this many requests */
+#define BATCH_MAX 64
+
+/* a connection is dropped once this many bytes of responses are waiting to
+   be sent, since its client has stopped reading */
+#define OUTPUT_BACKLOG_MAX (16 << 20)
+
+/* polls[0] is the listening socket and polls[1] the wake pipe; clients
+   follow */
+#define FIRST_CLIENT 2
+
+/* map, stations and lines files the daemon was started with */
+static string startup_files[3];
+
+/* one client connection; the socket is closed when the last reference
+   (held by the poll loop or by a queued request) goes away */
+struct Connection {
+  int fd;
+  mutex write_lock;   // guards output and failed
+  string output;      // responses not yet taken by the socket
+  bool failed;        // a send failed or the backlog grew too long
+  atomic<bool> hung_up; // the client has sent its last request
+  string input;       // bytes read but not yet forming a whole request
+
+  Connection(int f) : fd(f), failed(false), hung_up(false) {}
+  ~Connection() { close(fd); }
+};
+
+struct Job {
+  shared_ptr<Connection> conn;
+  RequestHeader header;
+  string payload;
+};
+
+/* queue of batches shared between the poll loop and the workers */
+class BatchQueue {
+private:
+  mutex lock;
+  condition_variable ready;
+  deque<vector<Job> > batches;
+  bool stopping;
+
+public:
+  BatchQueue() : stopping(false) {}
+
+  void push(vector<Job> &batch) {
+    {
+      lock_guard<mutex> guard(lock);
+      batches.push_back(vector<Job>());
+      batches.back().swap(batch);
+    }
+    ready.notify_one();
+  }
+
+  /* blocks for the next batch; returns false once stopped and drained */
+  bool pop(vector<Job> &batch) {
+    unique_lock<mutex> guard(lock);
+    while (batches.empty() && !stopping)
+      ready.wait(guard);
+    if (batches.empty())
+      return false;
+    batch.swap(batches.front());
+    batches.pop_front();
+    return true;
+  }
+
+  void stop() {
+    {
+      lock_guard<mutex> guard(lock);
+      stopping = true;
+    }
+    ready.notify_all();
+  }
+};
+
+static volatile sig_atomic_t shutdown_requested = 0;
+
+/* written to by workers to wake the poll loop when a connection has output
+   waiting; the poll loop reads from wake_pipe[0] */
+static int wake_pipe[2];
+
+static void wake_poll_loop() {
+  char byte = 0;
+  ssize_t ignored = write(wake_pipe[1], &byte, 1);
+  (void) ignored; // a full pipe already wakes the loop
+}
+
+static void on_signal(int) {
+  shutdown_requested = 1;
+}
+
+/* internal helper which sends as much of a buffer as the socket takes
+   without blocking; returns the bytes sent, or -1 if the client has gone */
+static ssize_t send_some(int fd, const char *data, size_t length) {
+  size_t sent = 0;
+  while (sent < length) {
+    ssize_t n = send(fd, data + sent, length - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (n <= 0)
+      return -1;
+    sent += n;
+  }
+  return sent;
+}
+
+/* internal helper which sends what it can of a connection's output; called
+   with write_lock held */
+static void flush_output(Connection &conn) {
+  ssize_t sent = send_some(conn.fd, conn.output.data(), conn.output.size());
+  if (sent < 0) {
+    conn.failed = true;
+    conn.output.clear();
+  } else {
+    conn.output.erase(0, sent);
+  }
+}
+
+/* internal helper which splits a payload of the form "uint16 length, first
+   string, second string (rest)"; returns false if it is malformed */
+static bool split_pair(const string &payload, string &first, string &second) {
+  uint16_t length;
+  if (payload.size() < sizeof(length))
+    return false;
+  memcpy(&length, payload.data(), sizeof(length));
+  if (payload.size() < sizeof(length) + length)
+    return false;
+  first.assign(payload, sizeof(length), length);
+  second.assign(payload, sizeof(length) + length, string::npos);
+  return true;
+}
+
+/* internal helper which reads the constraint lines of an OP_PLAN request;
+   returns false for an unknown constraint, station or line */
+static bool parse_constraints(const TubeNetwork &net, const string &text, PlanConstraints &constraints) {
+  size_t at = 0;
+  while (at < text.size()) {
+    size_t stop = text.find('\n', at);
+    if (stop == string::npos)
+      stop = text.size();
+    string item(text, at, stop - at);
+    at = stop + 1;
+
+    if (item.empty())
+      continue;
+    if (item == "step-free") {
+      constraints.step_free = true;
+    } else if (item.compare(0, 14, "avoid station ") == 0) {
+      uint32_t index = net.directory().station_index(get_station_id(net, item.c_str() + 14));
+      if (index == NO_STATION)
+        return false;
+      constraints.avoid_station(index);
+    } else if (item.compare(0, 11, "avoid line ") == 0) {
+      char symbol = get_line_symbol(net, item.c_str() + 11);
+      if (symbol == ' ')
+        return false;
+      constraints.avoid_line(symbol);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Function to answer one request, returning its status and filling in the
+   response payload */
+static int32_t handle(const TubeNetwork &net, const Job &job, string &out) {
+  switch (job.header.op) {
+  case OP_VALIDATE: {
+    string start, route;
+    if (!split_pair(job.payload, start, route))
+      return STATUS_BAD_REQUEST;
+    string end;
+    int result = validate_route(net, start.c_str(), route.c_str(), end);
+    if (result >= 0)
+      out = end;
+    return result;
+  }
+  case OP_PLAN: {
+    string from, rest;
+    if (!split_pair(job.payload, from, rest))
+      return STATUS_BAD_REQUEST;
+    size_t newline = rest.find('\n');
+    string to(rest, 0, newline);
+    PlanConstraints constraints;
+    if (newline != string::npos && !parse_constraints(net, rest.substr(newline + 1), constraints))
+      return STATUS_BAD_REQUEST;
+    return plan_journey(net, from.c_str(), to.c_str(), constraints, out);
+  }
+  case OP_LOOKUP: {
+    if (job.payload.empty())
+      return STATUS_BAD_REQUEST;
+    int k = (uint8_t) job.payload[0];
+    if (k > PREFIX_INDEX_TOP_K)
+      k = PREFIX_INDEX_TOP_K;
+    string prefix(job.payload, 1);
+    Completion found[PREFIX_INDEX_TOP_K];
+    int count = complete_station_or_line(net, prefix.c_str(), found, k);
+    for (int n = 0; n < count; n++) {
+      uint32_t id = found[n].id;
+      size_t length = strlen(found[n].name);
+      if (length > 255)
+        length = 255;
+      out.append((const char *) &id, sizeof(id));
+      out.push_back((char) found[n].is_line);
+      out.push_back((char) length);
+      out.append(found[n].name, length);
+    }
+    return count;
+  }
+  case OP_STATS:
+    out = tube_stats_json();
+    return STATUS_OK;
+  }
+  return STATUS_BAD_REQUEST;
+}
+
+/* internal helper which logs the parts of a newly loaded map cut off
+   from the rest, such as track joining no station */
+static void report_fragments(LiveTubeMap &live, const string &map_file) {
+  LiveTubeMap::Reader reader(live);
+  ostringstream lines;
+  if (reader->connectivity().report(lines))
+    cerr << "tubed: " << map_file << " has pieces cut off from the rest:\n" << lines.str() << flush;
+}
+
+/* Function to answer an OP_RELOAD request. Must run outside any read
+   section, since reload() waits for readers of the old map. */
+static int32_t handle_reload(LiveTubeMap &live, const Job &job, string &out) {
+  string files[3];
+  if (job.payload.empty()) {
+    for (int n = 0; n < 3; n++)
+      files[n] = startup_files[n];
+  } else {
+    size_t first = job.payload.find('\n');
+    size_t second = first == string::npos ? first : job.payload.find('\n', first + 1);
+    if (second == string::npos)
+      return STATUS_BAD_REQUEST;
+    files[0] = job.payload.substr(0, first);
+    files[1] = job.payload.substr(first + 1, second - first - 1);
+    files[2] = job.payload.substr(second + 1);
+  }
+
+  if (!live.reload(files[0].c_str(), files[1].c_str(), files[2].c_str()))
+    return STATUS_RELOAD_FAILED;
+  report_fragments(live, files[0]);
+  uint64_t generation = live.generation();
+  out.assign((const char *) &generation, sizeof(generation));
+  return STATUS_OK;
+}
+
+/* internal helper which sends one response, or as much as the socket will
+   take now, leaving the rest for the poll loop */
+static void respond(const Job &job, int32_t status, const string &payload) {
+  ResponseHeader response;
+  response.status = status;
+  response.request_id = job.header.request_id;
+  response.length = payload.size();
+
+  Connection &conn = *job.conn;
+  lock_guard<mutex> guard(conn.write_lock);
+  if (conn.failed)
+    return;
+  bool was_waiting = !conn.output.empty();
+  conn.output.append((const char *) &response, sizeof(response));
+  conn.output.append(payload);
+  if (!was_waiting)
+    flush_output(conn);
+  if (conn.output.size() > OUTPUT_BACKLOG_MAX) {
+    conn.failed = true;
+    conn.output.clear();
+  }
+  if (conn.failed || (!was_waiting && !conn.output.empty()) || conn.hung_up)
+    wake_poll_loop();
+}
+
+/* Function run by each worker thread: answers whole batches at a time, each
+   batch against a single snapshot of the map. The answers are kept until the
+   read section ends and only then written, since a client that stops reading
+   would otherwise hold the section open and stall every reload. */
+static void worker(LiveTubeMap *live, BatchQueue *queue) {
+  vector<Job> batch;
+  vector<int32_t> statuses;
+  vector<string> payloads;
+  while (queue->pop(batch)) {
+    statuses.assign(batch.size(), STATUS_OK);
+    if (payloads.size() < batch.size())
+      payloads.resize(batch.size());
+    {
+      LiveTubeMap::Reader snapshot(*live);
+      for (size_t n = 0; n < batch.size(); n++) {
+        payloads[n].clear();
+        if (batch[n].header.op != OP_RELOAD)
+          statuses[n] = handle(*snapshot.get(), batch[n], payloads[n]);
+      }
+    }
+    for (size_t n = 0; n < batch.size(); n++)
+      if (batch[n].header.op != OP_RELOAD)
+        respond(batch[n], statuses[n], payloads[n]);
+    for (size_t n = 0; n < batch.size(); n++)
+      if (batch[n].header.op == OP_RELOAD)
+        respond(batch[n], handle_reload(*live, batch[n], payloads[n]), payloads[n]);
+    batch.clear();
+  }
+}
+
+/* Function to read whatever a client has sent and move each complete
+   request into the pending batch; returns false if the connection should
+   be dropped. A client which has finished sending is marked hung_up, and
+   kept until its responses are sent. */
+static bool read_requests(shared_ptr<Connection> &conn, vector<Job> &pending) {
+  char buffer[65536];
+  ssize_t n = read(conn->fd, buffer, sizeof(buffer));
+  if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+    return true;
+  if (n < 0)
+    return false;
+  if (n == 0) {
+    conn->hung_up = true;
+    return true;
+  }
+  conn->input.append(buffer, n);
+
+  size_t used = 0;
+  while (conn->input.size() - used >= sizeof(RequestHeader)) {
+    Job job;
+    memcpy(&job.header, conn->input.data() + used, sizeof(RequestHeader));
+    if (job.header.length > TUBED_MAX_PAYLOAD)
+      return false;
+    if (conn->input.size() - used < sizeof(RequestHeader) + job.header.length)
+      break;
+    job.conn = conn;
+    job.payload.assign(conn->input, used + sizeof(RequestHeader), job.header.length);
+    pending.push_back(job);
+    used += sizeof(RequestHeader) + job.header.length;
+  }
+  conn->input.erase(0, used);
+  return true;
+}
+
+/* Function to create, bind and listen on the daemon's socket */
+static int open_socket(const char *path) {
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(path) >= sizeof(address.sun_path)) {
+    cerr << "tubed: socket path too long" << endl;
+    return -1;
+  }
+  strcpy(address.sun_path, path);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    perror("tubed: socket");
+    return -1;
+  }
+  unlink(path);
+  if (bind(fd, (sockaddr *) &address, sizeof(address)) < 0 || listen(fd, 128) < 0) {
+    perror("tubed: bind");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int main(int argc, char **argv) {
+  const char *socket_path = TUBED_DEFAULT_SOCKET;
+  int threads = thread::hardware_concurrency();
+  const char *files[3] = {"map.txt", "stations.txt", "lines.txt"};
+
+  int positional = 0;
+  for (int n = 1; n < argc; n++) {
+    if (!strcmp(argv[n], "-s") && n + 1 < argc)
+      socket_path = argv[++n];
+    else if (!strcmp(argv[n], "-t") && n + 1 < argc)
+      threads = atoi(argv[++n]);
+    else if (positional < 3)
+      files[positional++] = argv[n];
+    else {
+      cerr << "usage: tubed [-s socket] [-t threads] [map stations lines]" << endl;
+      return 1;
+    }
+  }
+  if (threads < 1)
+    threads = 1;
+  /* every worker, and the main thread, takes one of the map's reader slots */
+  if (threads > LIVE_MAP_READER_SLOTS - 1) {
+    threads = LIVE_MAP_READER_SLOTS - 1;
+    cerr << "tubed: using " << threads << " workers, the most supported" << endl;
+  }
+
+  for (int n = 0; n < 3; n++)
+    startup_files[n] = files[n];
+
+  LiveTubeMap live;
+  if (!live.reload(files[0], files[1], files[2])) {
+    cerr << "tubed: cannot load " << files[0] << endl;
+    return 1;
+  }
+  report_fragments(live, files[0]);
+
+  int listen_fd = open_socket(socket_path);
+  if (listen_fd < 0)
+    return 1;
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  if (pipe(wake_pipe) < 0 || fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK) < 0
+      || fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK) < 0) {
+    perror("tubed: pipe");
+    return 1;
+  }
+
+  BatchQueue queue;
+  vector<thread> workers;
+  for (int n = 0; n < threads; n++)
+    workers.push_back(thread(worker, &live, &queue));
+
+  cout << "tubed: serving " << files[0] << " on " << socket_path
+       << " with " << threads << " worker(s)" << endl;
+
+  /* polls[n] belongs to conns[n - FIRST_CLIENT] */
+  vector<pollfd> polls(FIRST_CLIENT);
+  vector<shared_ptr<Connection> > conns;
+  polls[0].fd = listen_fd;
+  polls[0].events = POLLIN;
+  polls[1].fd = wake_pipe[0];
+  polls[1].events = POLLIN;
+
+  vector<Job> pending;
+  chrono::steady_clock::time_point batch_start;
+
+  while (!shutdown_requested) {
+    /* watch each client for requests until it hangs up, and for room to
+       send while it has output waiting; drop those which failed, or which
+       hung up and have nothing more to send or still to answer */
+    for (size_t n = polls.size() - 1; n >= FIRST_CLIENT; n--) {
+      shared_ptr<Connection> &conn = conns[n - FIRST_CLIENT];
+      bool drop;
+      {
+        lock_guard<mutex> guard(conn->write_lock);
+        polls[n].events = (conn->hung_up ? 0 : POLLIN) | (conn->output.empty() ? 0 : POLLOUT);
+        drop = conn->failed || (conn->hung_up && conn->output.empty() && conn.use_count() == 1);
+      }
+      if (drop) {
+        polls[n] = polls.back();
+        polls.pop_back();
+        conns[n - FIRST_CLIENT] = conns.back();
+        conns.pop_back();
+      }
+    }
+
+    timespec timeout = {0, 0};
+    timespec *wait = NULL;
+    if (!pending.empty()) {
+      long long left = BATCH_WINDOW_US - chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - batch_start).count();
+      if (left > 0)
+        timeout.tv_nsec = left * 1000;
+      wait = &timeout;
+    }
+
+    if (ppoll(&polls[0], polls.size(), wait, NULL) < 0 && errno != EINTR) {
+      perror("tubed: poll");
+      break;
+    }
+
+    bool was_empty = pending.empty();
+
+    if (polls[1].revents & POLLIN) {
+      char drain[256];
+      while (read(wake_pipe[0], drain, sizeof(drain)) > 0)
+        ;
+    }
+
+    for (size_t n = polls.size() - 1; n >= FIRST_CLIENT; n--) {
+      short events = polls[n].revents;
+      if (!events)
+        continue;
+      shared_ptr<Connection> &conn = conns[n - FIRST_CLIENT];
+      bool keep = !(events & (POLLERR | POLLNVAL));
+      if (keep && (events & POLLOUT)) {
+        lock_guard<mutex> guard(conn->write_lock);
+        flush_output(*conn);
+        keep = !conn->failed;
+      }
+      if (keep && (events & POLLIN))
+        keep = read_requests(conn, pending);
+      else if (keep && (events & POLLHUP))
+        keep = false; // gone altogether, so nothing more can be sent
+      if (!keep) {
+        polls[n] = polls.back();
+        polls.pop_back();
+        conns[n - FIRST_CLIENT] = conns.back();
+        conns.pop_back();
+      }
+    }
+
+    if (polls[0].revents & POLLIN) {
+      int fd = accept(listen_fd, NULL, NULL);
+      if (fd >= 0 && fcntl(fd, F_SETFL, O_NONBLOCK) < 0) {
+        close(fd);
+        fd = -1;
+      }
+      if (fd >= 0) {
+        pollfd p;
+        p.fd = fd;
+        p.events = POLLIN;
+        p.revents = 0;
+        polls.push_back(p);
+        conns.push_back(shared_ptr<Connection>(new Connection(fd)));
+      }
+    }
+
+    if (was_empty && !pending.empty())
+      batch_start = chrono::steady_clock::now();
+
+    if (!pending.empty() && ((int) pending.size() >= BATCH_MAX ||
+        chrono::steady_clock::now() - batch_start >= chrono::microseconds(BATCH_WINDOW_US)))
+      queue.push(pending);
+  }
+
+  if (!pending.empty())
+    queue.push(pending);
+  queue.stop();
+  for (size_t n = 0; n < workers.size(); n++)
+    workers[n].join();
+
+  close(listen_fd);
+  close(wake_pipe[0]);
+  close(wake_pipe[1]);
+  unlink(socket_path);
+  return 0;
+}
@@ -0,0 +1,48 @@
+#ifndef TUBEEMBEDDED_H
+#define TUBEEMBEDDED_H
+
+/* Map, station and line tables compiled into the binary. embedded_map.h is
+   generated from the text files by mkembedded when building tube_embedded
+   (see the makefile); with TUBE_EMBEDDED defined, load_map() of that map
+   and the station and line lookups in tube.cpp use these tables and read
+   no files. */
+
+struct EmbeddedName {
+  char symbol;
+  const char *name;
+};
+
+#include "embedded_map.h"
+
+/* internal helper which compares two strings in a constant expression */
+constexpr bool embedded_names_equal(const char *a, const char *b) {
+  while (*a && *a == *b) {
+    a++;
+    b++;
+  }
+  return *a == *b;
+}
+
+/* returns the symbol of the named station or line, stations first, or ' ';
+   with a constant name this is evaluated by the compiler */
+constexpr char embedded_symbol_for(const char *name) {
+  if (!*name)
+    return ' ';
+  for (int n = 0; n < EMBEDDED_STATION_COUNT; n++)
+    if (embedded_names_equal(embedded_stations[n].name, name))
+      return embedded_stations[n].symbol;
+  for (int n = 0; n < EMBEDDED_LINE_COUNT; n++)
+    if (embedded_names_equal(embedded_lines[n].name, name))
+      return embedded_lines[n].symbol;
+  return ' ';
+}
+
+/* returns the name of the station with the given symbol, or NULL */
+constexpr const char *embedded_station_name(char symbol) {
+  for (int n = 0; n < EMBEDDED_STATION_COUNT; n++)
+    if (embedded_stations[n].symbol == symbol)
+      return embedded_stations[n].name;
+  return nullptr;
+}
+
+#endif
@@ -0,0 +1,704 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <cstdio>
+#include <algorithm>
+
+using namespace std;
+
+#include "tube.h"
+#include "tubemap.h"
+#include "maprender.h"
+#include "tubestats.h"
+
+
+/* internal helper which reads one line, dropping any trailing '\r' */
+static bool read_line(istream &in, string &line) {
+  if (!getline(in, line))
+    return false;
+  if (!line.empty() && line[line.size() - 1] == '\r')
+    line.erase(line.size() - 1);
+  return true;
+}
+
+
+/* Function to read the stations and lines files into the directory */
+bool StationDirectory::load(const char *stations_file, const char *lines_file, bool numeric_ids) {
+  ifstream in_stations(stations_file), in_lines(lines_file);
+  if (!in_stations || !in_lines)
+    return false;
+
+  this->numeric_ids = numeric_ids;
+  station_ids.clear();
+  station_names.clear();
+  station_flags.clear();
+  station_by_name.clear();
+  station_by_id.clear();
+  line_by_name.clear();
+  for (int n = 0; n < 256; n++)
+    line_names[n].clear();
+
+  string line;
+  while (read_line(in_stations, line)) {
+    if (line.empty())
+      continue;
+
+    StationId id;
+    size_t name_start;
+    if (numeric_ids) {
+      char *after;
+      unsigned long value = strtoul(line.c_str(), &after, 10);
+      if (after == line.c_str() || value >= NO_STATION)
+        return false; // malformed or reserved ID
+      id = (StationId) value;
+      name_start = (after - line.c_str()) + 1;
+    } else {
+      id = (unsigned char) line[0];
+      name_start = 2;
+    }
+    if (name_start > line.size())
+      return false;
+
+    /* anything after a tab is a list of attributes rather than the name */
+    size_t tab = line.find('\t', name_start);
+    string name = line.substr(name_start, tab == string::npos ? string::npos : tab - name_start);
+    uint8_t flags = 0;
+    if (tab != string::npos && line.find("step-free", tab) != string::npos)
+      flags |= STATION_STEP_FREE;
+
+    if (station_by_id.count(id))
+      continue; // first entry for an ID wins, as with the file scan
+    station_by_id[id] = station_ids.size();
+    station_by_name.insert(make_pair(name, (uint32_t) station_ids.size()));
+    station_ids.push_back(id);
+    station_names.push_back(name);
+    station_flags.push_back(flags);
+  }
+
+  while (read_line(in_lines, line)) {
+    if (line.size() < 2)
+      continue;
+    unsigned char symbol = line[0];
+    line_names[symbol] = line.substr(2);
+    line_by_name.insert(make_pair(line_names[symbol], (char) symbol));
+  }
+
+  return true;
+}
+
+/* Function to return the ID of a named station, or NO_STATION */
+StationId StationDirectory::find_station(const char name[]) const {
+  TUBE_STATS_COUNT(dictionary_lookups);
+  unordered_map<string, uint32_t>::const_iterator it = station_by_name.find(name);
+  if (it == station_by_name.end())
+    return NO_STATION;
+  return station_ids[it->second];
+}
+
+/* Function to return the name of a station, or NULL if the ID is unknown */
+const char *StationDirectory::station_name(StationId id) const {
+  TUBE_STATS_COUNT(dictionary_lookups);
+  unordered_map<StationId, uint32_t>::const_iterator it = station_by_id.find(id);
+  if (it == station_by_id.end())
+    return NULL;
+  return station_names[it->second].c_str();
+}
+
+/* Function to return the file position of a station, or NO_STATION */
+uint32_t StationDirectory::station_index(StationId id) const {
+  unordered_map<StationId, uint32_t>::const_iterator it = station_by_id.find(id);
+  if (it == station_by_id.end())
+    return NO_STATION;
+  return it->second;
+}
+
+/* Function to return the symbol of a named line, or ' ' */
+char StationDirectory::find_line(const char name[]) const {
+  TUBE_STATS_COUNT(dictionary_lookups);
+  unordered_map<string, char>::const_iterator it = line_by_name.find(name);
+  if (it == line_by_name.end())
+    return ' ';
+  return it->second;
+}
+
+/* Function to return the name of a line, or NULL if the symbol is unused */
+const char *StationDirectory::line_name(char symbol) const {
+  const string &name = line_names[(unsigned char) symbol];
+  if (name.empty())
+    return NULL;
+  return name.c_str();
+}
+
+
+/* Function to hash the directory's entries (64-bit FNV-1a) */
+uint64_t StationDirectory::fingerprint() const {
+  uint64_t hash = 14695981039346656037ull;
+  struct Mix {
+    static void bytes(uint64_t &hash, const void *data, size_t length) {
+      const unsigned char *p = (const unsigned char *) data;
+      for (size_t n = 0; n < length; n++) {
+        hash ^= p[n];
+        hash *= 1099511628211ull;
+      }
+    }
+  };
+
+  Mix::bytes(hash, &numeric_ids, sizeof(numeric_ids));
+  for (size_t n = 0; n < station_ids.size(); n++) {
+    Mix::bytes(hash, &station_ids[n], sizeof(StationId));
+    Mix::bytes(hash, station_names[n].c_str(), station_names[n].size() + 1);
+    Mix::bytes(hash, &station_flags[n], sizeof(uint8_t));
+  }
+  for (int n = 0; n < 256; n++)
+    Mix::bytes(hash, line_names[n].c_str(), line_names[n].size() + 1);
+  return hash;
+}
+
+/* Function to compare two directories entry by entry */
+bool StationDirectory::same_as(const StationDirectory &other) const {
+  if (numeric_ids != other.numeric_ids || station_ids != other.station_ids
+      || station_names != other.station_names || station_flags != other.station_flags)
+    return false;
+  for (int n = 0; n < 256; n++)
+    if (line_names[n] != other.line_names[n])
+      return false;
+  return true;
+}
+
+
+/* row and column offsets of each Direction */
+static const int direction_dr[8] = {-1, 1, 0, 0, -1, -1, 1, 1};
+static const int direction_dc[8] = {0, 0, -1, 1, 1, -1, 1, -1};
+
+/* Direction of each (dr + 1, dc + 1) step */
+static const Direction direction_of[3][3] = {
+  {NW, N, NE}, {W, INVALID_DIRECTION, E}, {SW, S, SE}
+};
+
+
+TubeMap::TubeMap() : compressed(false), height(0), width(0), extended(false), dir(new StationDirectory) {
+  memset(station_symbol, 0, sizeof(station_symbol));
+}
+
+/* Function to load a map in either format; returns false if any of the files
+   cannot be read or the extended side table does not match the grid */
+bool TubeMap::load(const char *map_file, const char *stations_file, const char *lines_file) {
+  TUBE_STATS_TIME(load_map);
+
+  if (!load_grid(map_file))
+    return false;
+  shared_ptr<StationDirectory> loaded(new StationDirectory);
+  if (!loaded->load(stations_file, lines_file, extended))
+    return false;
+  dir = loaded;
+  mark_exits();
+  return true;
+}
+
+/* Function to load a map that uses an existing directory */
+bool TubeMap::load(const char *map_file, const shared_ptr<const StationDirectory> &directory) {
+  TUBE_STATS_TIME(load_map);
+
+  if (!load_grid(map_file) || directory->has_numeric_ids() != extended)
+    return false;
+  dir = directory;
+  mark_exits();
+  return true;
+}
+
+/* Function to swap in an identical directory shared with another map */
+bool TubeMap::share_directory(const shared_ptr<const StationDirectory> &other) {
+  if (other != dir && !other->same_as(*dir))
+    return false;
+  dir = other;
+  return true;
+}
+
+/* internal helper which reads the grid and station cell index of a map */
+bool TubeMap::load_grid(const char *map_file) {
+  ifstream in(map_file);
+  if (!in)
+    return false;
+
+  vector<string> rows;
+  string line;
+  extended = false;
+
+  if (read_line(in, line)) {
+    if (line == EXTENDED_MAP_HEADER)
+      extended = true;
+    else
+      rows.push_back(line);
+  }
+  while (read_line(in, line)) {
+    if (extended && line == "%")
+      break;
+    rows.push_back(line);
+  }
+  if (rows.empty())
+    return false;
+
+  height = rows.size();
+  width = 0;
+  for (int r = 0; r < height; r++)
+    if ((int) rows[r].size() > width)
+      width = rows[r].size();
+
+  /* pad every row with spaces to the full width, as load_map() does */
+  compressed = false;
+  runs = RleGrid();
+  cells.assign((size_t) height * width, ' ');
+  for (int r = 0; r < height; r++)
+    memcpy(&cells[(size_t) r * width], rows[r].data(), rows[r].size());
+
+  memset(station_symbol, 0, sizeof(station_symbol));
+  junctions.clear();
+  station_cells.clear();
+
+  if (extended) {
+    station_symbol[(unsigned char) STATION_CELL] = true;
+
+    long r, c;
+    unsigned long id;
+    while (read_line(in, line)) {
+      if (line.empty())
+        continue;
+      if (sscanf(line.c_str(), "%ld %ld %lu", &r, &c, &id) != 3)
+        return false;
+      if (r < 0 || c < 0 || r >= height || c >= width || id >= NO_STATION)
+        return false;
+      if (cells[r * width + c] != STATION_CELL)
+        return false; // side table entry for a non-station cell
+      Junction j;
+      j.cell = r * width + c;
+      j.station = id;
+      junctions.push_back(j);
+      StationCells first;
+      first.first = j.cell;
+      station_cells.insert(make_pair((StationId) id, first));
+    }
+  } else {
+    for (int n = 0; n < 256; n++)
+      station_symbol[n] = isalnum(n);
+    /* legacy cells carry their own ID; only the first cell of each station
+       is indexed, matching get_symbol_position() */
+    for (size_t n = 0; n < cells.size(); n++) {
+      if (station_symbol[(unsigned char) cells[n]]) {
+        Junction j;
+        j.cell = n;
+        j.station = (unsigned char) cells[n];
+        junctions.push_back(j);
+        StationCells first;
+        first.first = n;
+        station_cells.insert(make_pair(j.station, first));
+      }
+    }
+  }
+
+  return index_junctions();
+}
+
+/* internal helper which sorts the station cells by position, a later side
+   table entry for a cell replacing an earlier one; returns false if an
+   extended map has station cells missing from its side table */
+bool TubeMap::index_junctions() {
+  stable_sort(junctions.begin(), junctions.end(), junction_before);
+  size_t kept = 0;
+  for (size_t n = 0; n < junctions.size(); n++) {
+    if (kept > 0 && junctions[kept - 1].cell == junctions[n].cell)
+      junctions[kept - 1] = junctions[n];
+    else
+      junctions[kept++] = junctions[n];
+  }
+  junctions.resize(kept);
+  vector<Junction>(junctions).swap(junctions);
+
+  if (extended)
+    return (size_t) count(cells.begin(), cells.end(), STATION_CELL) == junctions.size();
+  return true;
+}
+
+/* internal helper which returns the junction at a station cell, or NULL */
+const TubeMap::Junction *TubeMap::find_junction(uint32_t cell) const {
+  vector<Junction>::const_iterator it = lower_bound(junctions.begin(), junctions.end(), cell, junction_below);
+  if (it == junctions.end() || it->cell != cell)
+    return NULL;
+  return &*it;
+}
+
+/* internal helper which sets the lines of each station to those leaving
+   any of its cells, then records where each exit of a station cell leads.
+   An exit to a neighbouring station takes the one line the two stations
+   share, if there is exactly one. Run whenever the directory changes. */
+void TubeMap::mark_exits() {
+  for (unordered_map<StationId, StationCells>::iterator it = station_cells.begin(); it != station_cells.end(); ++it)
+    memset(it->second.lines, 0, sizeof(it->second.lines));
+
+  for (size_t n = 0; n < junctions.size(); n++) {
+    const Junction &j = junctions[n];
+    StationCells &station = station_cells[j.station];
+    int r = j.cell / width, c = j.cell % width;
+    for (int d = N; d < INVALID_DIRECTION; d++) {
+      int nr = r + direction_dr[d], nc = c + direction_dc[d];
+      if (nr < 0 || nc < 0 || nr >= height || nc >= width || is_station(nr, nc))
+        continue;
+      unsigned char symbol = cell(nr, nc);
+      if (symbol != ' ' && dir->line_name(symbol))
+        station.lines[symbol / 64] |= (uint64_t) 1 << (symbol % 64);
+    }
+  }
+
+  for (size_t n = 0; n < junctions.size(); n++) {
+    Junction &j = junctions[n];
+    const StationCells &station = station_cells[j.station];
+    int r = j.cell / width, c = j.cell % width;
+    j.inside = 0;
+    for (int d = N; d < INVALID_DIRECTION; d++) {
+      int nr = r + direction_dr[d], nc = c + direction_dc[d];
+      j.exit[d] = ' ';
+      if (nr < 0 || nc < 0 || nr >= height || nc >= width)
+        continue;
+      if (!is_station(nr, nc)) {
+        j.exit[d] = cell(nr, nc);
+        continue;
+      }
+      StationId next = station_at(nr, nc);
+      if (next == j.station) {
+        j.inside |= 1 << d;
+        continue;
+      }
+
+      /* the line between two stations is their only shared line */
+      const StationCells &other = station_cells[next];
+      j.exit[d] = JUNCTION_STATION;
+      int shared = 0;
+      for (int word = 0; word < 4; word++) {
+        uint64_t both = station.lines[word] & other.lines[word];
+        for (int bit = 0; bit < 64; bit++) {
+          if ((both >> bit) & 1) {
+            j.exit[d] = word * 64 + bit;
+            shared++;
+          }
+        }
+      }
+      if (shared != 1)
+        j.exit[d] = JUNCTION_STATION;
+    }
+  }
+}
+
+/* Function to write the map and stations in the extended format. Legacy
+   station symbols become their character codes. */
+bool TubeMap::save_extended(const char *map_file, const char *stations_file) const {
+  ofstream out_map(map_file), out_stations(stations_file);
+  if (!out_map || !out_stations)
+    return false;
+
+  out_map << EXTENDED_MAP_HEADER << '\n';
+  for (int r = 0; r < height; r++) {
+    for (int c = 0; c < width; c++)
+      out_map << (is_station(r, c) ? STATION_CELL : cell(r, c));
+    out_map << '\n';
+  }
+  out_map << "%\n";
+  for (int r = 0; r < height; r++)
+    for (int c = 0; c < width; c++)
+      if (is_station(r, c))
+        out_map << r << ' ' << c << ' ' << station_at(r, c) << '\n';
+
+  for (uint32_t n = 0; n < dir->station_count(); n++)
+    out_stations << dir->station_id_at(n) << ' ' << dir->station_name_at(n) << '\n';
+
+  return out_map && out_stations;
+}
+
+/* Function to run-length encode the grid and free the plain copy */
+bool TubeMap::compress() {
+  if (compressed)
+    return true;
+  if (!runs.encode(cells.data(), height, width))
+    return false;
+  vector<char>().swap(cells);
+  compressed = true;
+  return true;
+}
+
+size_t TubeMap::grid_bytes() const {
+  return compressed ? runs.memory_size() : cells.size();
+}
+
+/* Function to print the map */
+void TubeMap::print(ostream &out) const {
+  MapRenderer renderer;
+  renderer.render(*this, WHOLE_MAP);
+  renderer.write(out);
+}
+
+/* Function to copy part of a row; a compressed grid is expanded a run at
+   a time */
+void TubeMap::copy_row(int r, int left, int count, char out[]) const {
+  if (compressed)
+    runs.copy_row(r, left, count, out);
+  else
+    memcpy(out, &cells[(size_t) r * width + left], count);
+}
+
+/* Function to return the station at a cell, or NO_STATION */
+StationId TubeMap::station_at(int r, int c) const {
+  if (!is_station(r, c))
+    return NO_STATION;
+  if (!extended)
+    return (unsigned char) cell(r, c);
+  return find_junction(r * width + c)->station;
+}
+
+/* Function to find the first cell of a station, or (-1, -1) */
+bool TubeMap::station_position(StationId id, int &r, int &c) const {
+  unordered_map<StationId, StationCells>::const_iterator it = station_cells.find(id);
+  if (it == station_cells.end()) {
+    r = c = -1;
+    return false;
+  }
+  r = it->second.first / width;
+  c = it->second.first % width;
+  return true;
+}
+
+/* Function to test whether a line leaves a station */
+bool TubeMap::station_on_line(StationId id, char line) const {
+  unordered_map<StationId, StationCells>::const_iterator it = station_cells.find(id);
+  if (it == station_cells.end())
+    return false;
+  unsigned char symbol = line;
+  return (it->second.lines[symbol / 64] >> (symbol % 64)) & 1;
+}
+
+/* Function to list the lines leaving a station */
+int TubeMap::station_lines(StationId id, char lines[256]) const {
+  unordered_map<StationId, StationCells>::const_iterator it = station_cells.find(id);
+  if (it == station_cells.end())
+    return 0;
+  const StationCells &station = it->second;
+  int count = 0;
+  for (int symbol = 0; symbol < 256; symbol++)
+    if ((station.lines[symbol / 64] >> (symbol % 64)) & 1)
+      lines[count++] = symbol;
+  return count;
+}
+
+/* internal helper which copies a station's name into end, leaving end
+   untouched for NO_STATION or a station missing from the directory (as
+   get_station_name() does) */
+void TubeMap::copy_station_name(StationId id, char end[]) const {
+  if (id == NO_STATION)
+    return;
+  const char *name = dir->station_name(id);
+  if (name)
+    strcpy(end, name);
+}
+
+/* internal helper which starts a walk at a station */
+bool TubeMap::begin_walk(StationId start, RouteWalk &walk) const {
+  walk.r1 = walk.c1 = walk.r2 = walk.c2 = 0;
+  walk.line = JUNCTION_STATION;
+  walk.transfers = 0;
+  walk.steps = 0;
+  if (start == NO_STATION || !station_position(start, walk.r3, walk.c3))
+    return false;
+  if (walk.trace)
+    walk.trace->push_back(walk.r3 * width + walk.c3);
+  return true;
+}
+
+/* internal helper which moves a walk by (dr, dc) and applies the checks of
+   validate_route() to the new cell; returns 0 or an error code */
+int TubeMap::walk_step(RouteWalk &w, int dr, int dc) const {
+  w.steps++;
+  w.r1 = w.r2;
+  w.c1 = w.c2;
+  w.r2 = w.r3;
+  w.c2 = w.c3;
+  w.r3 += dr;
+  w.c3 += dc;
+
+  if (w.r3 < 0 || w.c3 < 0 || w.r3 >= height || w.c3 >= width)
+    return ERROR_OUT_OF_BOUNDS;
+  if (w.trace)
+    w.trace->push_back(w.r3 * width + w.c3);
+
+  if (cell(w.r3, w.c3) == ' ')
+    return ERROR_OFF_TRACK;
+
+  bool station2 = is_station(w.r2, w.c2);
+  bool station3 = is_station(w.r3, w.c3);
+
+  if (!station2 && !station3 && cell(w.r2, w.c2) != cell(w.r3, w.c3))
+    return ERROR_LINE_HOPPING_BETWEEN_STATIONS;
+
+  bool reversed = w.r1 == w.r3 && w.c1 == w.c3;
+  if (reversed && !station2)
+    return ERROR_BACKTRACKING_BETWEEN_STATIONS;
+
+  if (station2) {
+    /* the line arrived on was carried along the track, and the line left
+       on is the exit taken, so neither is read from the grid */
+    const Junction *j = find_junction(w.r2 * width + w.c2);
+    int d = direction_of[dr + 1][dc + 1];
+    if (reversed)
+      w.transfers++; // reversed direction at a station
+    if ((j->inside >> d) & 1)
+      return 0; // still inside the station, on the same line
+
+    char out = j->exit[d];
+    if (!reversed && (w.line == JUNCTION_STATION || out != w.line))
+      w.transfers++; // changed line at a station
+    w.line = out;
+  }
+  return 0;
+}
+
+/* Function to check if a route is valid. This follows validate_route() in
+   tube.cpp step for step, except that line changes at a station are read
+   from its exits, so two neighbouring stations on one line, or two cells of
+   one station, do not count as a transfer. */
+int TubeMap::validate_route(const char start[], const char route[], char end[]) const {
+  TUBE_STATS_TIME(validate_route);
+  RouteWalk walk;
+  walk.steps = 0;
+  walk.trace = NULL;
+  StationId end_id = NO_STATION;
+  int result = check_route(start, route, end_id, walk);
+  copy_station_name(end_id, end);
+  TUBE_STATS_RESULT(result);
+  TUBE_STATS_STEPS(walk.steps);
+  return result;
+}
+
+/* Function to check if a route is valid, returning the end station's name
+   as a string */
+int TubeMap::validate_route(const char start[], const char route[], string &end) const {
+  TUBE_STATS_TIME(validate_route);
+  RouteWalk walk;
+  walk.steps = 0;
+  walk.trace = NULL;
+  StationId end_id = NO_STATION;
+  int result = check_route(start, route, end_id, walk);
+  const char *name = end_id == NO_STATION ? NULL : dir->station_name(end_id);
+  if (name)
+    end = name;
+  TUBE_STATS_RESULT(result);
+  TUBE_STATS_STEPS(walk.steps);
+  return result;
+}
+
+/* Function to validate a route and record the cells it visits */
+int TubeMap::trace_route(const char start[], const char route[], char end[], vector<uint32_t> &path) const {
+  RouteWalk walk;
+  walk.steps = 0;
+  walk.trace = &path;
+  path.clear();
+  StationId end_id = NO_STATION;
+  int result = check_route(start, route, end_id, walk);
+  copy_station_name(end_id, end);
+  return result;
+}
+
+/* internal helper which does the work of validate_route(), setting end to
+   the final station of a valid route */
+int TubeMap::check_route(const char start[], const char route[], StationId &end, RouteWalk &walk) const {
+  StationId start_id = dir->find_station(start);
+  if (!begin_walk(start_id, walk))
+    return ERROR_START_STATION_INVALID;
+
+  if (route[0] == '\0') {
+    end = start_id;
+    return 0; // empty route: remain at the station
+  }
+
+  int i = 0;
+  while (route[i] != '\0') {
+    /* each step is N, S, E or W, optionally followed by E or W after N or S */
+    int dr = 0, dc = 0;
+    if (route[i] == 'N' || route[i] == 'S') {
+      dr = route[i] == 'N' ? -1 : 1;
+    } else if (route[i] == 'E' || route[i] == 'W') {
+      dc = route[i] == 'E' ? 1 : -1;
+    } else {
+      return ERROR_INVALID_DIRECTION;
+    }
+
+    int r = walk.r3 + dr, c = walk.c3 + dc;
+    if (r < 0 || c < 0 || r >= height || c >= width)
+      return ERROR_OUT_OF_BOUNDS; // checked per character, as in tube.cpp
+    i++;
+
+    if (isalnum(route[i])) {
+      if (dc != 0 || (route[i] != 'E' && route[i] != 'W'))
+        return ERROR_INVALID_DIRECTION; // 'EN', 'WS', 'SS', 'NQ', etc.
+      dc = route[i] == 'E' ? 1 : -1;
+      i++;
+      if (isalnum(route[i]))
+        return ERROR_INVALID_DIRECTION; // more than 2 characters
+    }
+
+    int error = walk_step(walk, dr, dc);
+    if (error)
+      return error;
+
+    if (route[i] != '\0')
+      i++; // skip the comma
+  }
+
+  if (!is_station(walk.r3, walk.c3))
+    return ERROR_ROUTE_ENDPOINT_IS_NOT_STATION;
+  end = station_at(walk.r3, walk.c3);
+  return walk.transfers - 1; // the first step always counts as a transfer
+}
+
+/* Function to check a route given as an array of directions; returns the
+   same codes as validate_route() and sets end to the final station. If
+   then_invalid is set the route went on with an invalid direction after
+   these steps, so it fails with ERROR_INVALID_DIRECTION unless a step
+   fails first. */
+int TubeMap::validate_steps(StationId start, const Direction steps[], int count, StationId &end, bool then_invalid) const {
+  TUBE_STATS_TIME(validate_route);
+  RouteWalk walk;
+  walk.steps = 0;
+  walk.trace = NULL;
+  int result = check_steps(start, steps, count, end, walk);
+  if (then_invalid && result != ERROR_START_STATION_INVALID
+      && (result >= 0 || result == ERROR_ROUTE_ENDPOINT_IS_NOT_STATION)) {
+    end = NO_STATION;
+    result = ERROR_INVALID_DIRECTION;
+  }
+  TUBE_STATS_RESULT(result);
+  TUBE_STATS_STEPS(walk.steps);
+  return result;
+}
+
+/* internal helper which does the work of validate_steps() */
+int TubeMap::check_steps(StationId start, const Direction steps[], int count, StationId &end, RouteWalk &walk) const {
+  end = NO_STATION;
+  if (!begin_walk(start, walk))
+    return ERROR_START_STATION_INVALID;
+
+  if (count == 0) {
+    end = start;
+    return 0;
+  }
+
+  for (int n = 0; n < count; n++) {
+    if (steps[n] < N || steps[n] >= INVALID_DIRECTION)
+      return ERROR_INVALID_DIRECTION;
+    int error = walk_step(walk, direction_dr[steps[n]], direction_dc[steps[n]]);
+    if (error)
+      return error;
+  }
+
+  if (!is_station(walk.r3, walk.c3))
+    return ERROR_ROUTE_ENDPOINT_IS_NOT_STATION;
+  end = station_at(walk.r3, walk.c3);
+  return walk.transfers - 1;
+}
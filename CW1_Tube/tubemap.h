@@ -0,0 +1,245 @@
+#ifndef TUBEMAP_H
+#define TUBEMAP_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <ostream>
+
+#include "tube.h"
+#include "rlegrid.h"
+
+using namespace std;
+
+/* 32-bit identifier of a station. Legacy maps use the station's symbol
+   character as its ID; extended maps carry arbitrary numeric IDs. */
+typedef uint32_t StationId;
+
+const StationId NO_STATION = 0xFFFFFFFFu;
+
+/* symbol written into every station cell of an extended map; the station
+   it belongs to is looked up in the map's side table */
+const char STATION_CELL = '@';
+
+/* exit recorded for a station cell next to another station */
+const char JUNCTION_STATION = '\0';
+
+/* station attribute flags, from an optional tab-separated column after
+   the station name ("A Paddington<TAB>step-free") */
+const uint8_t STATION_STEP_FREE = 1;
+
+/* first line of a map file in the extended format:
+
+     #TUBEMAP 2
+     <grid rows, with station cells marked by '@'>
+     %
+     <row> <column> <station id>      (one line per station cell)
+
+   The matching stations file lists "<station id> <name>" per line, with a
+   decimal ID. The lines file is the same as for legacy maps. */
+#define EXTENDED_MAP_HEADER "#TUBEMAP 2"
+
+
+/* Dictionary of station and line names, built once when a map is loaded. */
+class StationDirectory {
+private:
+  vector<StationId> station_ids;    // station IDs in file order
+  vector<string> station_names;     // names, parallel to station_ids
+  vector<uint8_t> station_flags;    // STATION_* flags, parallel to station_ids
+
+  unordered_map<string, uint32_t> station_by_name; // name -> index
+  unordered_map<StationId, uint32_t> station_by_id;  // ID -> index
+
+  string line_names[256];           // indexed by line symbol
+  unordered_map<string, char> line_by_name;
+
+  bool numeric_ids;                 // true for an extended stations file
+
+public:
+  StationDirectory() : numeric_ids(false) {}
+
+  /* reads the stations and lines files; numeric_ids selects between
+     "<decimal id> <name>" (extended) and "<symbol> <name>" (legacy) */
+  bool load(const char *stations_file, const char *lines_file, bool numeric_ids);
+
+  /* returns the ID of the named station, or NO_STATION */
+  StationId find_station(const char name[]) const;
+
+  /* returns the name of the station with the given ID, or NULL */
+  const char *station_name(StationId id) const;
+
+  /* returns the symbol of the named line, or ' ' */
+  char find_line(const char name[]) const;
+
+  /* returns the name of the line with the given symbol, or NULL */
+  const char *line_name(char symbol) const;
+
+  /* number of stations and their i-th entry in file order */
+  uint32_t station_count() const { return station_ids.size(); }
+  StationId station_id_at(uint32_t i) const { return station_ids[i]; }
+  const char *station_name_at(uint32_t i) const { return station_names[i].c_str(); }
+  uint8_t station_flags_at(uint32_t i) const { return station_flags[i]; }
+
+  /* returns the position of a station in file order, or NO_STATION */
+  uint32_t station_index(StationId id) const;
+
+  bool has_numeric_ids() const { return numeric_ids; }
+
+  /* hash of every station and line entry, equal for equal directories */
+  uint64_t fingerprint() const;
+
+  /* true if both directories hold exactly the same entries */
+  bool same_as(const StationDirectory &other) const;
+};
+
+
+/* A tube map held in memory together with its station index and name
+   directory. The grid is one byte per cell, or run-length encoded after
+   compress(); in extended maps the IDs of station cells live in a side
+   table, so a map is not limited to the ~62 stations that fit in
+   alphanumeric symbols. */
+class TubeMap {
+private:
+  vector<char> cells;       // row-major grid, height * width bytes
+  RleGrid runs;             // the grid instead, once compressed
+  bool compressed;
+  int height;
+  int width;
+  bool extended;            // true if loaded from the extended format
+
+  bool station_symbol[256]; // which cell symbols denote a station
+
+  /* a station cell and where each of its neighbours leads, so walks read
+     line changes from here instead of comparing cells around the station */
+  struct Junction {
+    uint32_t cell;       // row * width + column
+    StationId station;
+    char exit[8];        // by Direction: track symbol, line shared with the
+                         // station that way, JUNCTION_STATION or ' '
+    uint8_t inside;      // bit per Direction leading to the same station
+  };
+
+  /* a station's first cell, with the lines touching any of its cells */
+  struct StationCells {
+    uint32_t first;      // row * width + column
+    uint64_t lines[4];   // bit per symbol of a line from the lines file
+  };
+
+  vector<Junction> junctions;                        // sorted by cell
+  unordered_map<StationId, StationCells> station_cells;
+
+  static bool junction_before(const Junction &a, const Junction &b) { return a.cell < b.cell; }
+  static bool junction_below(const Junction &j, uint32_t cell) { return j.cell < cell; }
+
+  const Junction *find_junction(uint32_t cell) const;
+  bool index_junctions();
+  void mark_exits();
+
+  shared_ptr<const StationDirectory> dir;
+
+  bool load_grid(const char *map_file);
+
+  /* position of the last three cells visited by a route */
+  struct RouteWalk {
+    int r1, c1, r2, c2, r3, c3;
+    char line;        // line being travelled, or JUNCTION_STATION if unknown
+    int transfers;
+    int steps;        // steps taken so far
+    vector<uint32_t> *trace; // if set, receives each cell visited
+  };
+
+  void copy_station_name(StationId id, char end[]) const;
+  bool begin_walk(StationId start, RouteWalk &walk) const;
+  int walk_step(RouteWalk &walk, int dr, int dc) const;
+  int check_route(const char start[], const char route[], StationId &end, RouteWalk &walk) const;
+  int check_steps(StationId start, const Direction steps[], int count, StationId &end, RouteWalk &walk) const;
+
+public:
+  TubeMap();
+
+  /* loads a legacy or extended map (detected from its first line) together
+     with its stations and lines files */
+  bool load(const char *map_file, const char *stations_file, const char *lines_file);
+
+  /* loads a map that uses an already loaded directory, which must be in the
+     format the map needs */
+  bool load(const char *map_file, const shared_ptr<const StationDirectory> &directory);
+
+  /* switches to another directory holding the same entries as this map's,
+     so maps with identical stations and lines can share one copy; returns
+     false, changing nothing, if the entries differ */
+  bool share_directory(const shared_ptr<const StationDirectory> &other);
+
+  /* writes the map and its stations in the extended format */
+  bool save_extended(const char *map_file, const char *stations_file) const;
+
+  /* switches the grid to its run-length encoding, trading constant-time
+     cell lookups for a search over the runs of one row; returns false,
+     leaving the grid as it was, if the map is too wide to encode */
+  bool compress();
+
+  bool is_compressed() const { return compressed; }
+
+  /* bytes used by the grid in its current form */
+  size_t grid_bytes() const;
+
+  /* prints the map with row and column numbers, as print_map() does */
+  void print(ostream &out) const;
+
+  /* copies count cells of row r, starting at column left, into out */
+  void copy_row(int r, int left, int count, char out[]) const;
+
+  int get_height() const { return height; }
+  int get_width() const { return width; }
+  bool is_extended() const { return extended; }
+  const StationDirectory &directory() const { return *dir; }
+  const shared_ptr<const StationDirectory> &shared_directory() const { return dir; }
+
+  /* returns the symbol stored at (r, c) */
+  char cell(int r, int c) const {
+    return compressed ? runs.cell(r, c) : cells[r * width + c];
+  }
+
+  /* true if (r, c) is a station cell */
+  bool is_station(int r, int c) const {
+    return station_symbol[(unsigned char) cell(r, c)];
+  }
+
+  /* returns the station at (r, c), or NO_STATION for a non-station cell */
+  StationId station_at(int r, int c) const;
+
+  /* finds the first cell of a station; returns false with (-1, -1) if the
+     station does not appear on the map */
+  bool station_position(StationId id, int &r, int &c) const;
+
+  /* true if track of the given line (a symbol from the lines file) leaves
+     any cell of a station */
+  bool station_on_line(StationId id, char line) const;
+
+  /* fills lines with the symbols of the lines leaving any cell of a
+     station, in symbol order; returns how many there are */
+  int station_lines(StationId id, char lines[256]) const;
+
+  /* same semantics and error codes as validate_route() in tube.h, but
+     resolves stations through the in-memory indexes */
+  int validate_route(const char start[], const char route[], char end[]) const;
+
+  /* validates a route as above, setting end to the final station's name
+     however long it is; end is left untouched if the route is invalid */
+  int validate_route(const char start[], const char route[], string &end) const;
+
+  /* validates a route as validate_route() does, filling path with the cells
+     it visits (as row * width + column, starting station first) up to the
+     end of the route or the step that failed */
+  int trace_route(const char start[], const char route[], char end[], vector<uint32_t> &path) const;
+
+  /* checks a route already split into directions, without any parsing;
+     sets end to the final station of a valid route. then_invalid marks a
+     route that continued with an invalid direction after these steps. */
+  int validate_steps(StationId start, const Direction steps[], int count, StationId &end,
+                     bool then_invalid = false) const;
+};
+
+#endif
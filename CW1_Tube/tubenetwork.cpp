@@ -0,0 +1,127 @@
+#include <cstring>
+
+using namespace std;
+
+#include "tubenetwork.h"
+
+
+/* Function to load a network and build name tables of its own */
+bool TubeNetwork::load(const char *name, const char *map_file, const char *stations_file, const char *lines_file) {
+  if (!tube_map.load(map_file, stations_file, lines_file))
+    return false;
+
+  shared_ptr<NameTables> built(new NameTables);
+  built->directory = tube_map.shared_directory();
+  built->names.build(*built->directory);
+
+  network_name = name;
+  tables = built;
+  graph.build(tube_map);
+  components.build(tube_map);
+  journey_planner.build(graph, &components);
+  return true;
+}
+
+/* Function to adopt identical name tables from another network */
+bool TubeNetwork::share_tables(const shared_ptr<const NameTables> &other) {
+  if (!tube_map.share_directory(other->directory))
+    return false;
+  tables = other;
+  return true;
+}
+
+
+/* Function to load a network into the registry, sharing its name tables
+   with an already loaded network if their contents are identical */
+shared_ptr<const TubeNetwork> NetworkRegistry::load(const char *name, const char *map_file,
+                                                    const char *stations_file, const char *lines_file) {
+  shared_ptr<TubeNetwork> net(new TubeNetwork);
+  if (!net->load(name, map_file, stations_file, lines_file))
+    return shared_ptr<const TubeNetwork>();
+
+  uint64_t fingerprint = net->directory().fingerprint();
+
+  lock_guard<mutex> guard(lock);
+
+  bool shared = false;
+  typedef unordered_multimap<uint64_t, weak_ptr<const NameTables> >::iterator Iterator;
+  pair<Iterator, Iterator> range = tables.equal_range(fingerprint);
+  for (Iterator it = range.first; it != range.second && !shared; ) {
+    shared_ptr<const NameTables> existing = it->second.lock();
+    if (!existing) {
+      it = tables.erase(it); // every network using these tables has gone
+      continue;
+    }
+    shared = net->share_tables(existing);
+    ++it;
+  }
+  if (!shared)
+    tables.insert(make_pair(fingerprint, weak_ptr<const NameTables>(net->name_tables())));
+
+  networks[name] = net;
+  return net;
+}
+
+/* Function to return the named network, or NULL */
+shared_ptr<const TubeNetwork> NetworkRegistry::find(const char *name) const {
+  lock_guard<mutex> guard(lock);
+  map<string, shared_ptr<const TubeNetwork> >::const_iterator it = networks.find(name);
+  if (it == networks.end())
+    return shared_ptr<const TubeNetwork>();
+  return it->second;
+}
+
+/* Function to remove a network from the registry */
+bool NetworkRegistry::unload(const char *name) {
+  lock_guard<mutex> guard(lock);
+  return networks.erase(name) > 0;
+}
+
+int NetworkRegistry::network_count() const {
+  lock_guard<mutex> guard(lock);
+  return networks.size();
+}
+
+int NetworkRegistry::table_count() const {
+  lock_guard<mutex> guard(lock);
+  int count = 0;
+  typedef unordered_multimap<uint64_t, weak_ptr<const NameTables> >::const_iterator Iterator;
+  for (Iterator it = tables.begin(); it != tables.end(); ++it)
+    if (!it->second.expired())
+      count++;
+  return count;
+}
+
+
+StationId get_station_id(const TubeNetwork &net, const char name[]) {
+  return net.directory().find_station(name);
+}
+
+char get_line_symbol(const TubeNetwork &net, const char name[]) {
+  return net.directory().find_line(name);
+}
+
+const char *get_station_name(const TubeNetwork &net, StationId id) {
+  return net.directory().station_name(id);
+}
+
+bool get_station_position(const TubeNetwork &net, StationId id, int &r, int &c) {
+  return net.get_map().station_position(id, r, c);
+}
+
+int complete_station_or_line(const TubeNetwork &net, const char prefix[], Completion out[], int k) {
+  return net.names().complete(prefix, out, k);
+}
+
+int validate_route(const TubeNetwork &net, const char start[], const char route[], char end[]) {
+  return net.get_map().validate_route(start, route, end);
+}
+
+int validate_route(const TubeNetwork &net, const char start[], const char route[], string &end) {
+  return net.get_map().validate_route(start, route, end);
+}
+
+int plan_journey(const TubeNetwork &net, const char from[], const char to[],
+                 const PlanConstraints &constraints, string &route) {
+  return net.planner().plan(from, to, constraints, route);
+}
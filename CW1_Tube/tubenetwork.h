@@ -0,0 +1,118 @@
+#ifndef TUBENETWORK_H
+#define TUBENETWORK_H
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+#include "tube.h"
+#include "tubemap.h"
+#include "prefixindex.h"
+#include "stationgraph.h"
+#include "planner.h"
+#include "connectivity.h"
+
+using namespace std;
+
+/* Station and line tables together with the prefix index built over them.
+   Networks loaded from identical stations and lines files share one copy. */
+struct NameTables {
+  shared_ptr<const StationDirectory> directory;
+  PrefixIndex names;
+};
+
+
+/* One named network (tube, overground, a night-tube variant, ...): a map plus
+   every index built for it. Once loaded a network is never modified (its
+   planner's cache aside, which has a lock of its own), so any number of
+   threads may query it. */
+class TubeNetwork {
+private:
+  string network_name;
+  TubeMap tube_map;
+  shared_ptr<const NameTables> tables;
+  StationGraph graph;
+  LineConnectivity components;
+  JourneyPlanner journey_planner;
+
+public:
+  /* loads a network with its own name tables */
+  bool load(const char *name, const char *map_file, const char *stations_file, const char *lines_file);
+
+  /* switches to identical name tables held by another network; returns
+     false, changing nothing, if their entries differ */
+  bool share_tables(const shared_ptr<const NameTables> &other);
+
+  const string &get_name() const { return network_name; }
+  const TubeMap &get_map() const { return tube_map; }
+  const StationDirectory &directory() const { return *tables->directory; }
+  const PrefixIndex &names() const { return tables->names; }
+  const shared_ptr<const NameTables> &name_tables() const { return tables; }
+  const StationGraph &station_graph() const { return graph; }
+  const LineConnectivity &connectivity() const { return components; }
+  const JourneyPlanner &planner() const { return journey_planner; }
+};
+
+
+/* Networks loaded side by side in one process, looked up by name. Name
+   tables are deduplicated by content as networks are loaded, so memory
+   grows with the number of distinct station and line tables rather than
+   with the number of networks. */
+class NetworkRegistry {
+private:
+  mutable mutex lock;
+  map<string, shared_ptr<const TubeNetwork> > networks;
+  unordered_multimap<uint64_t, weak_ptr<const NameTables> > tables; // by fingerprint
+
+public:
+  /* loads a network under a name, replacing any network of that name;
+     returns NULL if the files cannot be loaded */
+  shared_ptr<const TubeNetwork> load(const char *name, const char *map_file,
+                                     const char *stations_file, const char *lines_file);
+
+  /* returns the named network, or NULL */
+  shared_ptr<const TubeNetwork> find(const char *name) const;
+
+  /* removes a network; queries already holding it keep it alive */
+  bool unload(const char *name);
+
+  int network_count() const;
+
+  /* number of distinct name tables still in use */
+  int table_count() const;
+};
+
+
+/* Query functions. Each takes the network to query; the char ** functions
+   in tube.h remain for the single map they were written for. */
+
+/* returns the ID of the named station, or NO_STATION */
+StationId get_station_id(const TubeNetwork &net, const char name[]);
+
+/* returns the symbol of the named line, or ' ' */
+char get_line_symbol(const TubeNetwork &net, const char name[]);
+
+/* returns the name of a station, or NULL */
+const char *get_station_name(const TubeNetwork &net, StationId id);
+
+/* finds the first cell of a station, or (-1, -1) */
+bool get_station_position(const TubeNetwork &net, StationId id, int &r, int &c);
+
+/* fills out with up to k station and line names starting with prefix */
+int complete_station_or_line(const TubeNetwork &net, const char prefix[], Completion out[], int k);
+
+/* validates a route, with the result codes of validate_route() in tube.h */
+int validate_route(const TubeNetwork &net, const char start[], const char route[], char end[]);
+
+/* as above, with the end station's name of any length returned in end */
+int validate_route(const TubeNetwork &net, const char start[], const char route[], string &end);
+
+/* plans a journey between named stations, with the results of
+   JourneyPlanner::plan() */
+int plan_journey(const TubeNetwork &net, const char from[], const char to[],
+                 const PlanConstraints &constraints, string &route);
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef TUBEPROTO_H
+#define TUBEPROTO_H
+
+#include <stdint.h>
+
+/* Binary protocol spoken by tubed over its Unix domain socket. Both ends
+   run on the same host, so integers travel in host byte order.
+
+   Every request is a RequestHeader followed by length payload bytes, and is
+   answered by a ResponseHeader carrying the same request_id followed by
+   length payload bytes. A client may pipeline any number of requests on one
+   connection; responses can arrive out of order.
+
+   OP_VALIDATE  request:  uint16 start_length, start name, route (rest)
+                response: status = validate_route() result;
+                          payload = end station name when status >= 0
+   OP_PLAN      request:  uint16 from_length, from name, to name, then any
+                          number of "\n"-separated constraints: "step-free",
+                          "avoid station NAME", "avoid line NAME"
+                response: status = JourneyPlanner::plan() result;
+                          payload = route when status >= 0
+   OP_LOOKUP    request:  uint8 k, name prefix (rest)
+                response: status = number of completions, each encoded as
+                          uint32 id, uint8 is_line, uint8 name_length, name
+   OP_RELOAD    request:  empty to reload the files given at startup, or
+                          "map\nstations\nlines"
+                response: status = STATUS_OK with the new uint64 generation
+                          as payload, or STATUS_RELOAD_FAILED; queries keep
+                          being answered from the old map meanwhile
+   OP_STATS     request:  empty
+                response: status = STATUS_OK, payload = tube_stats_json() */
+
+#define TUBED_DEFAULT_SOCKET "/tmp/tubed.sock"
+
+/* largest payload accepted in either direction */
+#define TUBED_MAX_PAYLOAD 65536
+
+enum TubeOp { OP_VALIDATE = 1, OP_PLAN = 2, OP_LOOKUP = 3, OP_RELOAD = 4,
+             OP_STATS = 5 };
+
+/* status codes beyond those returned by validate_route() */
+#define STATUS_OK 0
+#define STATUS_BAD_REQUEST -100
+#define STATUS_UNSUPPORTED -101
+#define STATUS_RELOAD_FAILED -102
+
+struct RequestHeader {
+  uint32_t length;      // payload bytes following the header
+  uint32_t request_id;  // chosen by the client, echoed in the response
+  uint8_t op;           // a TubeOp
+  uint8_t reserved[3];
+};
+
+struct ResponseHeader {
+  uint32_t length;      // payload bytes following the header
+  uint32_t request_id;
+  int32_t status;
+};
+
+#endif
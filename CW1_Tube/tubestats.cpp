@@ -0,0 +1,137 @@
+#include <sstream>
+
+using namespace std;
+
+#include "tubestats.h"
+
+#ifdef TUBE_NO_STATS
+
+string tube_stats_json() {
+  return "{}";
+}
+
+void tube_stats_reset() {}
+
+#else
+
+TubeStats tube_stats;
+
+/* internal helper which returns the bucket holding a value */
+static int bucket_of(uint64_t value) {
+  if (value < 4)
+    return value;
+  int msb = 63 - __builtin_clzll(value);
+  return 4 * (msb - 1) + ((value >> (msb - 2)) & 3);
+}
+
+/* internal helper which returns the smallest value held by a bucket */
+static uint64_t bucket_floor(int bucket) {
+  if (bucket < 4)
+    return bucket;
+  int msb = bucket / 4 + 1;
+  return (uint64_t) (4 + bucket % 4) << (msb - 2);
+}
+
+/* Function to add one value to a histogram */
+void StatsHistogram::record(uint64_t value) {
+  buckets[bucket_of(value)].fetch_add(1, memory_order_relaxed);
+  sum.fetch_add(value, memory_order_relaxed);
+  uint64_t seen = max.load(memory_order_relaxed);
+  while (value > seen && !max.compare_exchange_weak(seen, value, memory_order_relaxed))
+    ;
+}
+
+/* internal helper which writes one histogram as a JSON object, with
+   percentiles reported as the floor of the bucket they fall in */
+static void histogram_json(ostream &out, const StatsHistogram &h) {
+  uint64_t counts[STATS_BUCKETS];
+  uint64_t total = 0;
+  for (int n = 0; n < STATS_BUCKETS; n++) {
+    counts[n] = h.buckets[n].load(memory_order_relaxed);
+    total += counts[n];
+  }
+
+  out << "{\"count\":" << total
+      << ",\"sum\":" << h.sum.load(memory_order_relaxed)
+      << ",\"max\":" << h.max.load(memory_order_relaxed);
+
+  const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+  const char *names[] = {"p50", "p90", "p99", "p999"};
+  for (int q = 0; q < 4; q++) {
+    uint64_t rank = (uint64_t) (quantiles[q] * total);
+    uint64_t seen = 0;
+    int n = 0;
+    while (n < STATS_BUCKETS - 1 && seen + counts[n] <= rank)
+      seen += counts[n++];
+    out << ",\"" << names[q] << "\":" << (total ? bucket_floor(n) : 0);
+  }
+
+  out << ",\"buckets\":[";
+  bool first = true;
+  for (int n = 0; n < STATS_BUCKETS; n++) {
+    if (!counts[n])
+      continue;
+    out << (first ? "" : ",") << '[' << bucket_floor(n) << ',' << counts[n] << ']';
+    first = false;
+  }
+  out << "]}";
+}
+
+/* Function to dump every counter and histogram as JSON */
+string tube_stats_json() {
+  const char *result_names[STATS_RESULT_CODES] = {
+    "VALID",
+    "ERROR_START_STATION_INVALID",
+    "ERROR_ROUTE_ENDPOINT_IS_NOT_STATION",
+    "ERROR_LINE_HOPPING_BETWEEN_STATIONS",
+    "ERROR_BACKTRACKING_BETWEEN_STATIONS",
+    "ERROR_INVALID_DIRECTION",
+    "ERROR_OFF_TRACK",
+    "ERROR_OUT_OF_BOUNDS"
+  };
+
+  ostringstream out;
+  out << "{\"results\":{";
+  for (int n = 0; n < STATS_RESULT_CODES; n++)
+    out << (n ? "," : "") << '"' << result_names[n] << "\":"
+        << tube_stats.results[n].load(memory_order_relaxed);
+  out << "},\"dictionary_lookups\":" << tube_stats.dictionary_lookups.load(memory_order_relaxed);
+
+  struct { const char *name; const StatsHistogram *h; } histograms[] = {
+    {"load_map_ns", &tube_stats.load_map},
+    {"name_completion_ns", &tube_stats.name_completion},
+    {"validate_route_ns", &tube_stats.validate_route},
+    {"route_file_open_ns", &tube_stats.route_file_open},
+    {"route_decode_ns", &tube_stats.route_decode},
+    {"route_steps", &tube_stats.route_steps}
+  };
+  for (size_t n = 0; n < sizeof(histograms) / sizeof(histograms[0]); n++) {
+    out << ",\"" << histograms[n].name << "\":";
+    histogram_json(out, *histograms[n].h);
+  }
+  out << "}";
+  return out.str();
+}
+
+/* internal helper which zeroes one histogram */
+static void histogram_reset(StatsHistogram &h) {
+  for (int n = 0; n < STATS_BUCKETS; n++)
+    h.buckets[n].store(0, memory_order_relaxed);
+  h.sum.store(0, memory_order_relaxed);
+  h.max.store(0, memory_order_relaxed);
+}
+
+/* Function to zero every counter and histogram */
+void tube_stats_reset() {
+  histogram_reset(tube_stats.load_map);
+  histogram_reset(tube_stats.name_completion);
+  histogram_reset(tube_stats.validate_route);
+  histogram_reset(tube_stats.route_file_open);
+  histogram_reset(tube_stats.route_decode);
+  histogram_reset(tube_stats.route_steps);
+  tube_stats.dictionary_lookups.store(0, memory_order_relaxed);
+  for (int n = 0; n < STATS_RESULT_CODES; n++)
+    tube_stats.results[n].store(0, memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef TUBESTATS_H
+#define TUBESTATS_H
+
+/* Counters and latency histograms for the hot paths of the tube engine.
+
+   Every instrumented call records through the TUBE_STATS_* macros below.
+   Building with -DTUBE_NO_STATS (make STATS=0) turns the macros into
+   nothing, and tube_stats_json() then returns an empty object. */
+
+#include <stdint.h>
+#include <string>
+
+using namespace std;
+
+/* returns a JSON object with every counter and histogram */
+string tube_stats_json();
+
+/* zeroes every counter and histogram */
+void tube_stats_reset();
+
+#ifdef TUBE_NO_STATS
+
+#define TUBE_STATS_TIME(histogram)
+#define TUBE_STATS_COUNT(counter)
+#define TUBE_STATS_RESULT(code)
+#define TUBE_STATS_STEPS(count)
+
+#else
+
+#include <atomic>
+#include <chrono>
+
+/* Log-bucketed histogram in the style of HDR histograms: values below 4
+   have a bucket each, and every power of two above that is split into four
+   sub-buckets, giving 25% resolution over the whole 64-bit range. */
+#define STATS_BUCKETS 252
+
+struct StatsHistogram {
+  atomic<uint64_t> buckets[STATS_BUCKETS];
+  atomic<uint64_t> sum;
+  atomic<uint64_t> max;
+
+  void record(uint64_t value);
+};
+
+/* result codes are counted at index -code, with valid routes at 0 */
+#define STATS_RESULT_CODES 8
+
+struct TubeStats {
+  StatsHistogram load_map;          // ns per map load, file I/O included
+  StatsHistogram name_completion;   // ns per prefix index query
+  StatsHistogram validate_route;    // ns per route validation
+  StatsHistogram route_file_open;   // ns to map and check a route file
+  StatsHistogram route_decode;      // ns to unpack one binary route
+  StatsHistogram route_steps;       // steps walked per validated route
+
+  /* lookups take well under a microsecond, so reading the clock around
+     each would cost more than the lookup; they are only counted */
+  atomic<uint64_t> dictionary_lookups;  // station and line name lookups
+
+  atomic<uint64_t> results[STATS_RESULT_CODES];
+};
+
+extern TubeStats tube_stats;
+
+/* records the lifetime of the enclosing scope into a histogram */
+class StatsTimer {
+private:
+  StatsHistogram &histogram;
+  chrono::steady_clock::time_point started;
+
+public:
+  StatsTimer(StatsHistogram &h) : histogram(h), started(chrono::steady_clock::now()) {}
+  ~StatsTimer() {
+    histogram.record(chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now() - started).count());
+  }
+};
+
+#define TUBE_STATS_TIME(histogram) \
+  StatsTimer tube_stats_timer(tube_stats.histogram)
+
+#define TUBE_STATS_COUNT(counter) \
+  tube_stats.counter.fetch_add(1, memory_order_relaxed)
+
+#define TUBE_STATS_RESULT(code) do { \
+    int tube_stats_code = (code) >= 0 ? 0 : -(code); \
+    if (tube_stats_code < STATS_RESULT_CODES) \
+      tube_stats.results[tube_stats_code].fetch_add(1, memory_order_relaxed); \
+  } while (0)
+
+#define TUBE_STATS_STEPS(count) tube_stats.route_steps.record(count)
+
+#endif
+
+#endif
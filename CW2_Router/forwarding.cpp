@@ -0,0 +1,66 @@
+#include <vector>
+
+#include "forwarding.h"
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for an empty ForwardingTable. */
+/* --------------------------------------------------------------------------- */
+ForwardingTable::ForwardingTable() : count(0) {}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the slot at which the search for a destination starts:
+   Fibonacci hashing, so that consecutive addresses spread over the table. */
+/* --------------------------------------------------------------------------- */
+unsigned int ForwardingTable::firstSlot(int destination) const {
+  unsigned int hash = (unsigned int) destination * 2654435769u;
+  return (hash ^ (hash >> 16)) & (slots.size() - 1);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to empty the table, making room for the given number of entries. */
+/* --------------------------------------------------------------------------- */
+void ForwardingTable::clear(unsigned int entries) {
+  unsigned int size = 8;
+  while (size < 2 * entries) {
+    size *= 2;
+  }
+  Entry empty = {0, NULL, NULL};
+  slots.assign(size, empty);
+  count = 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to add the next hop for a destination Host: either a neighboring
+   Router, or the Host itself. */
+/* --------------------------------------------------------------------------- */
+void ForwardingTable::add(int destination, Router *router, Host *host) {
+  if (2 * (count + 1) > slots.size()) {
+    // Grow the table, adding the entries again.
+    vector<Entry> old = slots;
+    clear(2 * (count + 1));
+    for (unsigned int i = 0; i < old.size(); i++) {
+      if ((old[i].router != NULL) || (old[i].host != NULL)) {
+        add(old[i].destination, old[i].router, old[i].host);
+      }
+    }
+  }
+
+  unsigned int mask = slots.size() - 1;
+  unsigned int i = firstSlot(destination);
+  while ((slots[i].router != NULL) || (slots[i].host != NULL)) {
+    i = (i + 1) & mask;
+  }
+  slots[i].destination = destination;
+  slots[i].router = router;
+  slots[i].host = host;
+  count++;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of destinations in the table. */
+/* --------------------------------------------------------------------------- */
+unsigned int ForwardingTable::size() const {
+  return count;
+}
@@ -0,0 +1,76 @@
+#ifndef FORWARDING_H
+#define FORWARDING_H
+#include <cstddef>
+#include <vector>
+
+using namespace std;
+
+class Router;
+class Host;
+
+class ForwardingTable {
+public:
+  struct Entry {
+    int destination;  // int address of the destination Host.
+    Router *router;   // the next Router on the way, or NULL if the Host is
+    Host *host;       // connected directly, in which case host is set.
+  };
+
+private:
+  vector<Entry> slots;   // Open addressing with linear probing. A slot with
+                         // neither router nor host set is empty. The number of
+                         // slots is a power of two, at least twice the number
+                         // of entries.
+
+  unsigned int count;    // Number of entries in the table.
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the slot at which the search for a destination starts. */
+/* --------------------------------------------------------------------------- */
+  unsigned int firstSlot(int destination) const;
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for an empty ForwardingTable. */
+/* --------------------------------------------------------------------------- */
+  ForwardingTable();
+
+/* --------------------------------------------------------------------------- */
+/* Function to empty the table, making room for the given number of entries. */
+/* --------------------------------------------------------------------------- */
+  void clear(unsigned int entries);
+
+/* --------------------------------------------------------------------------- */
+/* Function to add the next hop for a destination Host: either a neighboring
+   Router, or the Host itself. The destination must not already be in the
+   table. */
+/* --------------------------------------------------------------------------- */
+  void add(int destination, Router *router, Host *host);
+
+/* --------------------------------------------------------------------------- */
+/* Function to look up the next hop for a destination Host. Returns NULL if
+   there is no route to the Host. */
+/* --------------------------------------------------------------------------- */
+  const Entry *find(int destination) const {
+    if (count == 0) {
+      return NULL;
+    }
+    unsigned int mask = slots.size() - 1;
+    for (unsigned int i = firstSlot(destination); ; i = (i + 1) & mask) {
+      const Entry &e = slots[i];
+      if ((e.router == NULL) && (e.host == NULL)) {
+        return NULL;
+      }
+      if (e.destination == destination) {
+        return &e;
+      }
+    }
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of destinations in the table. */
+/* --------------------------------------------------------------------------- */
+  unsigned int size() const;
+};
+
+#endif
@@ -0,0 +1,206 @@
+#include <string>
+#include <vector>
+#include <set>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+#include "generator.h"
+
+using namespace std;
+
+static const char *TOPOLOGY_NAMES[] = {
+  "line", "ring", "grid", "erdos-renyi", "barabasi-albert", "fat-tree"
+};
+
+static const char *TRAFFIC_NAMES[] = { "uniform", "permutation", "hotspot" };
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for a NetworkGenerator with the given seed. */
+/* --------------------------------------------------------------------------- */
+NetworkGenerator::NetworkGenerator(unsigned int seed) : random(seed) {}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return a random int from 0 to n - 1. */
+/* --------------------------------------------------------------------------- */
+int NetworkGenerator::below(int n) {
+  return uniform_int_distribution<int>(0, n - 1)(this->random);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to convert between a kind of topology or traffic and its name. */
+/* --------------------------------------------------------------------------- */
+const char *NetworkGenerator::topologyName(TopologyKind kind) {
+  return TOPOLOGY_NAMES[kind];
+}
+
+bool NetworkGenerator::parseTopology(const string &name, TopologyKind &kind) {
+  for (int k = LINE; k <= FAT_TREE; k++) {
+    if (name == TOPOLOGY_NAMES[k]) {
+      kind = (TopologyKind) k;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+const char *NetworkGenerator::trafficName(TrafficKind kind) {
+  return TRAFFIC_NAMES[kind];
+}
+
+bool NetworkGenerator::parseTraffic(const string &name, TrafficKind &kind) {
+  for (int k = UNIFORM; k <= HOTSPOT; k++) {
+    if (name == TRAFFIC_NAMES[k]) {
+      kind = (TrafficKind) k;
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to make the links of a network of about the given number of
+   Routers, setting routers to the exact number. */
+/* --------------------------------------------------------------------------- */
+vector<pair<int, int> > NetworkGenerator::links(TopologyKind kind, int size, int degree,
+                                                int &routers) {
+  vector<pair<int, int> > made;
+  routers = max(size, 2);
+
+  if ((kind == LINE) || (kind == RING)) {
+    for (int r = 1; r < routers; r++) {
+      made.push_back(pair<int, int>(r - 1, r));
+    }
+    if ((kind == RING) && (routers > 2)) {
+      made.push_back(pair<int, int>(routers - 1, 0));
+    }
+
+  } else if (kind == GRID) {
+    int side = max(2, (int) (sqrt((double) size) + 0.5));
+    routers = side * side;
+    for (int row = 0; row < side; row++) {
+      for (int col = 0; col < side; col++) {
+        int r = row * side + col;
+        if (col + 1 < side) {
+          made.push_back(pair<int, int>(r, r + 1));
+        }
+        if (row + 1 < side) {
+          made.push_back(pair<int, int>(r, r + side));
+        }
+      }
+    }
+
+  } else if (kind == ERDOS_RENYI) {
+    // G(n, m): the given number of distinct links, chosen at random.
+    long most = (long) routers * (routers - 1) / 2;
+    long wanted = min(most, (long) routers * max(degree, 1) / 2);
+    set<pair<int, int> > chosen;
+    while ((long) chosen.size() < wanted) {
+      int a = this->below(routers);
+      int b = this->below(routers);
+      if (a == b) {
+        continue;
+      }
+      pair<int, int> link(min(a, b), max(a, b));
+      if (chosen.insert(link).second) {
+        made.push_back(link);
+      }
+    }
+
+  } else if (kind == BARABASI_ALBERT) {
+    // Each new Router links to m existing ones, chosen in proportion to the
+    // links they already have, starting from a clique of m + 1 Routers.
+    int m = max(1, min(degree, routers - 1));
+    vector<int> ends;   // every end of every link so far.
+    for (int a = 0; a <= m; a++) {
+      for (int b = a + 1; b <= m; b++) {
+        made.push_back(pair<int, int>(a, b));
+        ends.push_back(a);
+        ends.push_back(b);
+      }
+    }
+    for (int r = m + 1; r < routers; r++) {
+      set<int> targets;
+      while ((int) targets.size() < m) {
+        targets.insert(ends[this->below(ends.size())]);
+      }
+      for (set<int>::iterator t = targets.begin(); t != targets.end(); t++) {
+        made.push_back(pair<int, int>(*t, r));
+        ends.push_back(*t);
+        ends.push_back(r);
+      }
+    }
+
+  } else if (kind == FAT_TREE) {
+    // A k-ary fat tree: k pods of k/2 edge and k/2 aggregation switches, with
+    // every edge switch linked to every aggregation switch in its pod, and
+    // aggregation switch i of each pod linked to core switches i*k/2 to
+    // (i+1)*k/2 - 1. Core switches come first, then each pod's aggregation
+    // and edge switches.
+    int k = 2;
+    while (5 * k * k / 4 < size) {
+      k += 2;
+    }
+    int half = k / 2;
+    int cores = half * half;
+    routers = cores + k * k;
+    for (int pod = 0; pod < k; pod++) {
+      int first_aggregate = cores + pod * k;
+      int first_edge = first_aggregate + half;
+      for (int a = 0; a < half; a++) {
+        for (int e = 0; e < half; e++) {
+          made.push_back(pair<int, int>(first_aggregate + a, first_edge + e));
+        }
+        for (int c = 0; c < half; c++) {
+          made.push_back(pair<int, int>(a * half + c, first_aggregate + a));
+        }
+      }
+    }
+  }
+  return made;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to make a list of Messages to send between the given number of
+   Hosts, as (source, destination) pairs. */
+/* --------------------------------------------------------------------------- */
+vector<pair<int, int> > NetworkGenerator::traffic(TrafficKind kind, int hosts, int count) {
+  vector<pair<int, int> > made;
+  if (hosts < 2) {
+    return made;
+  }
+
+  // For PERMUTATION, a random order of the Hosts in which each sends to the
+  // next, so that none sends to itself.
+  vector<int> order;
+  vector<int> partner(hosts);
+  if (kind == PERMUTATION) {
+    for (int h = 0; h < hosts; h++) {
+      order.push_back(h);
+    }
+    shuffle(order.begin(), order.end(), this->random);
+    for (int n = 0; n < hosts; n++) {
+      partner[order[n]] = order[(n + 1) % hosts];
+    }
+  }
+
+  for (int n = 0; n < count; n++) {
+    int source = this->below(hosts);
+    int destination;
+    if (kind == PERMUTATION) {
+      destination = partner[source];
+    } else if ((kind == HOTSPOT) && (n % 2 == 0)) {
+      if (source == 0) {
+        source = 1 + this->below(hosts - 1);
+      }
+      destination = 0;
+    } else {
+      destination = this->below(hosts - 1);
+      if (destination >= source) {
+        destination++;
+      }
+    }
+    made.push_back(pair<int, int>(source, destination));
+  }
+  return made;
+}
@@ -0,0 +1,63 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+#include <string>
+#include <vector>
+#include <random>
+
+using namespace std;
+
+enum TopologyKind { LINE, RING, GRID, ERDOS_RENYI, BARABASI_ALBERT, FAT_TREE };
+
+enum TrafficKind { UNIFORM, PERMUTATION, HOTSPOT };
+
+/* --------------------------------------------------------------------------- */
+/* Makes up networks, and traffic to send across them, for benchmarks. A
+   network is described by the number of Routers, numbered from 0, and the
+   links between them; every Router has one Host with the same number. The
+   same seed always gives the same networks and traffic. */
+/* --------------------------------------------------------------------------- */
+class NetworkGenerator {
+private:
+  mt19937 random;
+
+/* --------------------------------------------------------------------------- */
+/* Function to return a random int from 0 to n - 1. */
+/* --------------------------------------------------------------------------- */
+  int below(int n);
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for a NetworkGenerator with the given seed. */
+/* --------------------------------------------------------------------------- */
+  NetworkGenerator(unsigned int seed);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to convert between a kind of topology or traffic and its name,
+   as used on the command line. The parse functions return FALSE if the name
+   is not known. */
+/* --------------------------------------------------------------------------- */
+  static const char *topologyName(TopologyKind kind);
+  static bool parseTopology(const string &name, TopologyKind &kind);
+  static const char *trafficName(TrafficKind kind);
+  static bool parseTraffic(const string &name, TrafficKind &kind);
+
+/* --------------------------------------------------------------------------- */
+/* Function to make the links of a network of about the given number of
+   Routers, setting routers to the exact number. The degree is the average
+   number of links per Router for ERDOS_RENYI, the links each new Router makes
+   for BARABASI_ALBERT, and unused otherwise. A GRID is the nearest square,
+   and a FAT_TREE the smallest k-ary fat tree (with 5k^2/4 switches) of at
+   least the given size. Each link appears once. */
+/* --------------------------------------------------------------------------- */
+  vector<pair<int, int> > links(TopologyKind kind, int size, int degree, int &routers);
+
+/* --------------------------------------------------------------------------- */
+/* Function to make a list of Messages to send between the given number of
+   Hosts, as (source, destination) pairs, never from a Host to itself:
+   UNIFORM picks both at random, PERMUTATION has each Host always send to the
+   same other Host, and HOTSPOT sends half of all Messages to Host 0. */
+/* --------------------------------------------------------------------------- */
+  vector<pair<int, int> > traffic(TrafficKind kind, int hosts, int count);
+};
+
+#endif
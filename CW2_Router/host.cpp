@@ -3,13 +3,15 @@
 #include "host.h"
 #include "router.h"
 #include "message.h"
+#include "simulator.h"
+#include "runtime.h"
 
 using namespace std;
 
 /* --------------------------------------------------------------------------- */
 /* Constructor function for a Host. Its connection is initialized to NULL. */
 /* --------------------------------------------------------------------------- */
-Host::Host(int n) : number(n), connection(NULL) {}
+Host::Host(int n) : number(n), connection(NULL), simulator(NULL), runtime(NULL) {}
 
 /* --------------------------------------------------------------------------- */
 /* Function to return the Router* connection of a Host. */
@@ -47,15 +49,48 @@ void Host::disconnectFrom(Router *r) {
     this->connection = NULL;
 }
 
+/* --------------------------------------------------------------------------- */
+/* Function to attach a Host to a Simulator, or to detach it with NULL. */
+/* --------------------------------------------------------------------------- */
+void Host::setSimulator(Simulator *s) {
+  this->simulator = s;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to attach a Host to a Runtime, or to detach it with NULL. */
+/* --------------------------------------------------------------------------- */
+void Host::setRuntime(Runtime *r) {
+  this->runtime = r;
+}
+
 /* --------------------------------------------------------------------------- */
 /* Function for a Host to send a Message to another Host. Takes an integer 
    as the destination Host number and a character string to produce a Message
-   and forwards this to the Host's connection Router. */
+   and forwards this to the Host's connection Router, or hands it to the
+   Host's Simulator or Runtime if it has one. */
 /* --------------------------------------------------------------------------- */
 void Host::send(int destination, const char* message) {
-  cout << "Host " << this->getNumber() << " sent a message to Host " << destination << ": " << message << endl << endl;
+  this->send(destination, Payload(message));
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function for a Host to send a Payload to another Host. */
+/* --------------------------------------------------------------------------- */
+void Host::send(int destination, const Payload &payload) {
+  if (this->simulator != NULL) {
+    (this->simulator)->send(*this, destination, payload);
+    return;
+  }
+  if (this->runtime != NULL) {
+    (this->runtime)->send(*this, destination, payload);
+    return;
+  }
+
+  cout << "Host " << this->getNumber() << " sent a message to Host " << destination << ": ";
+  cout.write(payload.data(), payload.size());
+  cout << endl << endl;
 
-  Message mess(this->getNumber(), destination, message);
+  Message mess(this->getNumber(), destination, payload);
   (this->connection)->receiveMessage(mess);
   
 }
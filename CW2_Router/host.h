@@ -2,10 +2,14 @@
 #define HOST_H
 #include <string>
 
+#include "payload.h"
+
 using namespace std;
 
 class Router;
 class Message;
+class Simulator;
+class Runtime;
 
 class Host {
 private:
@@ -13,6 +17,12 @@ private:
 
   Router* connection; // pointer to the Router to which the Host is connected.
 
+  Simulator* simulator; // the Simulator which carries the Host's Messages, or
+                        // NULL for them to be passed on at once.
+
+  Runtime* runtime;     // the Runtime which forwards the Host's Messages on
+                        // its worker threads, or NULL.
+
 public:
 /* --------------------------------------------------------------------------- */
 /* Constructor function for a Host. Its connection is initialized to NULL. */
@@ -45,13 +55,33 @@ public:
 /* --------------------------------------------------------------------------- */
   void disconnectFrom(Router *r);
 
+/* --------------------------------------------------------------------------- */
+/* Function to attach a Host to a Simulator, so that the Messages it sends take
+   simulated time to cross the network, or to detach it with NULL. */
+/* --------------------------------------------------------------------------- */
+  void setSimulator(Simulator *s);
+
+/* --------------------------------------------------------------------------- */
+/* Function to attach a Host to a Runtime, so that the Messages it sends are
+   forwarded by the Runtime's worker threads, or to detach it with NULL. This
+   is done by Runtime::attach(). */
+/* --------------------------------------------------------------------------- */
+  void setRuntime(Runtime *r);
+
 /* --------------------------------------------------------------------------- */
 /* Function for a Host to send a Message to another Host. Takes an integer 
    as the destination Host number and a character string to produce a Message
-   and forwards this to the Host's connection Router. */
+   and forwards this to the Host's connection Router, or hands it to the
+   Host's Simulator or Runtime if it has one. */
 /* --------------------------------------------------------------------------- */
   void send (int destination, const char* message);
 
+/* --------------------------------------------------------------------------- */
+/* Function for a Host to send a Payload to another Host. The Payload's bytes
+   are not copied, so the same Payload can be sent to many Hosts. */
+/* --------------------------------------------------------------------------- */
+  void send (int destination, const Payload &payload);
+
 /* --------------------------------------------------------------------------- */
 /* Function for when a Host receives a message. Prints confirmation of receipt
    and the Message contents to the screen. */
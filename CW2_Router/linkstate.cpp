@@ -0,0 +1,222 @@
+#include <vector>
+#include <map>
+#include <queue>
+#include <algorithm>
+
+#include "linkstate.h"
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for an empty LinkStateDatabase. */
+/* --------------------------------------------------------------------------- */
+LinkStateDatabase::LinkStateDatabase() 
+  : renumber(0), searchRoot(0), searchStale(1) {
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to add an advertisement to the database, replacing any older one
+   from the same Router. Returns TRUE if the database changed, in which case
+   the advertisement should be passed on. */
+/* --------------------------------------------------------------------------- */
+bool LinkStateDatabase::install(const shared_ptr<const LinkState> &state) {
+  shared_ptr<const LinkState> &held = states[state->router];
+  if (held && held->sequence >= state->sequence) {
+    return 0;
+  }
+  // A Router already numbered keeps its number; a new one means numbering
+  // the Routers again before the next search.
+  if (!held) {
+    this->renumber = 1;
+  }
+  held = state;
+  if (!(this->renumber)) {
+    int n = (this->index)[state->router];
+    (this->numbered)[n] = state.get();
+    this->numberLinks(n);
+  }
+  this->searchStale = 1;
+  return 1;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return every advertisement in the database, as sent to a newly
+   connected neighbor so that the two databases agree. */
+/* --------------------------------------------------------------------------- */
+vector<shared_ptr<const LinkState> > LinkStateDatabase::contents() {
+  vector<shared_ptr<const LinkState> > all;
+  for (unordered_map<int, shared_ptr<const LinkState> >::iterator i = states.begin();
+       i != states.end();
+       i++)
+  {
+    all.push_back(i->second);
+  }
+  return all;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of Routers in the database. */
+/* --------------------------------------------------------------------------- */
+int LinkStateDatabase::size() {
+  return states.size();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to number the Routers in address order, so that ties between 
+   equally short routes are broken the same way every time. */
+/* --------------------------------------------------------------------------- */
+void LinkStateDatabase::numberRouters() {
+  vector<pair<int, const LinkState *> > sorted;
+  for (unordered_map<int, shared_ptr<const LinkState> >::iterator i = states.begin();
+       i != states.end();
+       i++)
+  {
+    sorted.push_back(make_pair(i->first, (i->second).get()));
+  }
+  sort(sorted.begin(), sorted.end());
+
+  (this->addresses).resize(sorted.size());
+  (this->numbered).resize(sorted.size());
+  (this->index).clear();
+  (this->index).reserve(sorted.size());
+  for (unsigned int n = 0; n < sorted.size(); n++) {
+    (this->addresses)[n] = sorted[n].first;
+    (this->numbered)[n] = sorted[n].second;
+    (this->index)[sorted[n].first] = n;
+  }
+  (this->links).resize(sorted.size());
+  for (unsigned int n = 0; n < sorted.size(); n++) {
+    this->numberLinks(n);
+  }
+  this->renumber = 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to fill in the numbers of a numbered Router's neighbors from its
+   advertisement. Routers are numbered in address order, so the numbers come
+   in order as the addresses do. */
+/* --------------------------------------------------------------------------- */
+void LinkStateDatabase::numberLinks(int n) {
+  const vector<int> &neighbors = (this->numbered)[n]->neighbors;
+  vector<int> &numbers = (this->links)[n];
+  numbers.clear();
+  for (unsigned int m = 0; m < neighbors.size(); m++) {
+    unordered_map<int, int>::iterator found = (this->index).find(neighbors[m]);
+    if (found != (this->index).end()) {
+      numbers.push_back(found->second);
+    }
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to run Dijkstra's algorithm from the Router root, unless the last
+   search began there and the database has not changed since. Returns FALSE 
+   if root is not in the database. */
+/* --------------------------------------------------------------------------- */
+bool LinkStateDatabase::search(int root) {
+  if (states.count(root) == 0) {
+    return 0;
+  }
+  if (!(this->searchStale) && (this->searchRoot == root)) {
+    return 1;
+  }
+  if (this->renumber) {
+    this->numberRouters();
+  }
+
+  const int unreached = -1;
+  (this->distance).assign((this->numbered).size(), unreached);
+  (this->previous).assign((this->numbered).size(), unreached);
+  (this->firstHop).assign((this->numbered).size(), unreached);
+  (this->settled).clear();
+  priority_queue<pair<int, int>, vector<pair<int, int> >,
+                 greater<pair<int, int> > > frontier; // (distance, Router)
+
+  int start = (this->index)[root];
+  distance[start] = 0;
+  firstHop[start] = start;
+  frontier.push(make_pair(0, start));
+
+  while (!frontier.empty()) {
+    pair<int, int> top = frontier.top();
+    frontier.pop();
+    int u = top.second;
+    if (top.first > distance[u]) {
+      continue;
+    }
+    settled.push_back(u);
+
+    const vector<int> &neighbors = links[u];
+    for (unsigned int n = 0; n < neighbors.size(); n++) {
+      int v = neighbors[n];
+      // Use the link only if the neighbor advertises it too.
+      if (!binary_search(links[v].begin(), links[v].end(), u)) {
+        continue;
+      }
+      if ((distance[v] == unreached) || (distance[u] + 1 < distance[v])) {
+        distance[v] = distance[u] + 1;
+        previous[v] = u;
+        firstHop[v] = (u == start) ? v : firstHop[u];
+        frontier.push(make_pair(distance[v], v));
+      }
+    }
+  }
+
+  this->searchRoot = root;
+  this->searchStale = 0;
+  return 1;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to find the first step of the shortest route from the Router root
+   to every Host reachable from it. Routers are taken nearest first, so the 
+   first entry for a Host is its shortest route. */
+/* --------------------------------------------------------------------------- */
+void LinkStateDatabase::firstHops(int root, vector<pair<int, int> > &hops) {
+  hops.clear();
+  if (!(this->search(root))) {
+    return;
+  }
+  for (unsigned int n = 0; n < (this->settled).size(); n++) {
+    int t = (this->settled)[n];
+    int hop = (this->addresses)[(this->firstHop)[t]];
+    const vector<int> &hosts = (this->numbered)[t]->hosts;
+    for (unsigned int h = 0; h < hosts.size(); h++) {
+      hops.push_back(make_pair(hosts[h], hop));
+    }
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to compute the shortest route from the Router root to every Host
+   reachable from it, as firstHops() does. The routes are only built when they
+   are asked for, from the Router before each on its route. */
+/* --------------------------------------------------------------------------- */
+void LinkStateDatabase::shortestPaths(int root, multimap<int, Path> &routes) {
+  if (!(this->search(root))) {
+    routes.clear();
+    return;
+  }
+
+  const int unreached = -1;
+  const vector<const LinkState *> &state = this->numbered;
+  int start = (this->index)[root];
+
+  // Write a route to every Host of every reached Router, built from the Host
+  // back towards root. The old routes are kept until the new ones are made, so
+  // that routes which have not changed keep their nodes.
+  multimap<int, Path> fresh;
+  for (unsigned int t = 0; t < state.size(); t++) {
+    if ((this->distance)[t] == unreached) {
+      continue;
+    }
+    for (unsigned int h = 0; h < state[t]->hosts.size(); h++) {
+      Path route(state[t]->hosts[h]);
+      for (int n = t; n != start; n = (this->previous)[n]) {
+        route = Path((this->addresses)[n], route);
+      }
+      fresh.insert(pair<int, Path>(state[t]->hosts[h], route));
+    }
+  }
+  routes.swap(fresh);
+}
@@ -0,0 +1,113 @@
+#ifndef LINKSTATE_H
+#define LINKSTATE_H
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+
+#include "path.h"
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* A link-state advertisement: what one Router tells its network about itself,
+   namely the Routers and Hosts it is connected to. A Router numbers its
+   advertisements in order, so that a Router receiving two can tell which is
+   newer. An advertisement is never changed once made, and is shared by every
+   database holding it. */
+/* --------------------------------------------------------------------------- */
+struct LinkState {
+  int router;             // address of the advertising Router.
+  unsigned int sequence;  // grows with every advertisement the Router makes.
+  vector<int> neighbors;  // addresses of neighboring Routers, in order.
+  vector<int> hosts;      // addresses of connected Hosts, in order.
+};
+
+class LinkStateDatabase {
+private:
+  unordered_map<int, shared_ptr<const LinkState> > states; // The newest
+                                                           // advertisement from
+                                                           // each Router, by
+                                                           // Router address.
+
+  vector<int> addresses;              // Router addresses in order; a Router's
+                                      // place here is its number in searches.
+  vector<const LinkState *> numbered; // The newest advertisement of each
+                                      // numbered Router.
+  unordered_map<int, int> index;      // The number of each Router address.
+  vector<vector<int> > links;         // The numbers of each numbered Router's
+                                      // neighbors, in order.
+  bool renumber;                      // TRUE when a Router has joined since
+                                      // the Routers were last numbered.
+
+  int searchRoot;                     // The Router the last search began at.
+  bool searchStale;                   // TRUE when the database has changed
+                                      // since the last search.
+  vector<int> distance;               // Links from root to each numbered
+                                      // Router, or -1 if it was not reached.
+  vector<int> previous;               // The Router before each on its route.
+  vector<int> firstHop;               // The Router after root on each route.
+  vector<int> settled;                // The Routers reached, nearest first.
+
+/* --------------------------------------------------------------------------- */
+/* Function to number the Routers in address order, so that ties between 
+   equally short routes are broken the same way every time. */
+/* --------------------------------------------------------------------------- */
+  void numberRouters();
+
+/* --------------------------------------------------------------------------- */
+/* Function to fill in the numbers of a numbered Router's neighbors from its
+   advertisement, leaving out Routers not in the database. */
+/* --------------------------------------------------------------------------- */
+  void numberLinks(int n);
+
+/* --------------------------------------------------------------------------- */
+/* Function to run Dijkstra's algorithm from the Router root, unless the last
+   search began there and the database has not changed since. Returns FALSE 
+   if root is not in the database. */
+/* --------------------------------------------------------------------------- */
+  bool search(int root);
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for an empty LinkStateDatabase. */
+/* --------------------------------------------------------------------------- */
+  LinkStateDatabase();
+
+/* --------------------------------------------------------------------------- */
+/* Function to add an advertisement to the database, replacing any older one
+   from the same Router. Returns TRUE if the database changed, in which case
+   the advertisement should be passed on. */
+/* --------------------------------------------------------------------------- */
+  bool install(const shared_ptr<const LinkState> &state);
+
+/* --------------------------------------------------------------------------- */
+/* Function to return every advertisement in the database, as sent to a newly
+   connected neighbor so that the two databases agree. */
+/* --------------------------------------------------------------------------- */
+  vector<shared_ptr<const LinkState> > contents();
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of Routers in the database. */
+/* --------------------------------------------------------------------------- */
+  int size();
+
+/* --------------------------------------------------------------------------- */
+/* Function to find the first step of the shortest route from the Router root
+   to every Host reachable from it, by Dijkstra's algorithm with every link 
+   costing 1. A link is only used if the Routers at both ends advertise it, so
+   that the stale advertisements of Routers cut off from root are ignored. 
+   Each entry of hops is a Host and the Router after root on the way to it, or
+   root itself for its own Hosts, nearest Hosts first. */
+/* --------------------------------------------------------------------------- */
+  void firstHops(int root, vector<pair<int, int> > &hops);
+
+/* --------------------------------------------------------------------------- */
+/* Function to compute the shortest route from the Router root to every Host
+   reachable from it, as firstHops() does. Routes take the form used in a 
+   Router's routeMap: the Routers after root, then the Host. */
+/* --------------------------------------------------------------------------- */
+  void shortestPaths(int root, multimap<int, Path> &routes);
+};
+
+#endif
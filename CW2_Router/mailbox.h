@@ -0,0 +1,98 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+#include <cstddef>
+#include <atomic>
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* A queue which any number of threads may put letters into, and one thread at
+   a time takes them out of, without locks. Letters are linked through their
+   own next pointer, so putting one in allocates nothing. This is Vyukov's
+   intrusive queue: a putter swaps itself in as the newest letter with one
+   atomic exchange, then links the letter before it to itself. Between the two
+   steps the chain is broken, and take() returns NULL as though the mailbox
+   were empty, although hasMail() is TRUE; the taker should come back later.
+   T must have a member atomic<T *> next. */
+/* --------------------------------------------------------------------------- */
+template <class T>
+class Mailbox {
+private:
+  atomic<T *> newest;  // the letter put in last, or stub.
+
+  T *oldest;           // the letter to be taken next, or stub. Only the taker
+                       // uses it.
+
+  T stub;              // stands in for a letter when the mailbox is empty.
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for an empty Mailbox. */
+/* --------------------------------------------------------------------------- */
+  Mailbox() : newest(&stub), oldest(&stub) {
+    (stub.next).store(NULL, memory_order_relaxed);
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to put a letter in the mailbox, from any thread. */
+/* --------------------------------------------------------------------------- */
+  void put(T *letter) {
+    (letter->next).store(NULL, memory_order_relaxed);
+    T *previous = newest.exchange(letter);
+    (previous->next).store(letter, memory_order_release);
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to take the oldest letter out of the mailbox, or return NULL if
+   there is none that can be taken yet. Only one thread may take at a time. */
+/* --------------------------------------------------------------------------- */
+  T *take() {
+    T *letter = oldest;
+    T *next = (letter->next).load(memory_order_acquire);
+    if (letter == &stub) {
+      if (next == NULL) {
+        return NULL;
+      }
+      oldest = next;
+      letter = next;
+      next = (next->next).load(memory_order_acquire);
+    }
+    if (next != NULL) {
+      oldest = next;
+      return letter;
+    }
+
+    // The letter is the last one linked. Unless a putter is part way through,
+    // it is the newest, and the stub goes in behind it so that it can be taken.
+    if (letter != newest.load()) {
+      return NULL;
+    }
+    put(&stub);
+    next = (letter->next).load(memory_order_acquire);
+    if (next != NULL) {
+      oldest = next;
+      return letter;
+    }
+    return NULL;
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to check whether anything has been put in the mailbox and not yet
+   taken out, including a letter a putter is part way through putting in. Only
+   the taker may call it. */
+/* --------------------------------------------------------------------------- */
+  bool hasMail() {
+    return (oldest != &stub) || (newest.load() != &stub);
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to check whether anything has been put in the mailbox since the
+   taker last found it empty. Unlike hasMail(), any thread may call it, so the
+   taker can use it after handing the mailbox on to another. */
+/* --------------------------------------------------------------------------- */
+  bool hasNewMail() {
+    return newest.load() != &stub;
+  }
+};
+
+#endif
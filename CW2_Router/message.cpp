@@ -1,6 +1,6 @@
 #include <iostream>
 #include <vector>
-#include <string.h>
+#include <utility>
 
 #include "message.h"
 
@@ -8,31 +8,35 @@ using namespace std;
 
 /* --------------------------------------------------------------------------- */
 /* Constructor function for a Message. This requires a source Host int adress,
-   a destination Host int adress, and a character string for a message. It
-   dynamically allocates memory for a character array of the message string a 
-   Host wishes to send. */
-/* --------------------------------------------------------------------------- */
-Message::Message(int s, int d, const char *mess) {
-    this->message = new char [strlen(mess)+1];
-    strcpy(this->message, mess);
-    this->source = s;
-    this->destination = d;
-}
+   a destination Host int adress, and a character string for a message, which
+   is copied into the Message's Payload. */
+/* --------------------------------------------------------------------------- */
+Message::Message(int s, int d, const char *mess) : source(s), destination(d), payload(mess) {}
 
 /* --------------------------------------------------------------------------- */
-/* Destructor function for a Message. Since a Message dynamically allocates 
-   memory on the heap for the message string, the called destructor must delete
-   this memory, lest it create a memory leak. */
+/* Constructor function for a Message carrying an existing Payload. */
+/* --------------------------------------------------------------------------- */
+Message::Message(int s, int d, const Payload &p) : source(s), destination(d), payload(p) {}
+
 /* --------------------------------------------------------------------------- */
-Message::~Message() {
-    delete [] message;
+/* Functions to move a Message, taking over its Payload. */
+/* --------------------------------------------------------------------------- */
+Message::Message(Message &&other)
+  : source(other.source), destination(other.destination), payload(move(other.payload)) {}
+
+Message &Message::operator=(Message &&other) {
+  this->source = other.source;
+  this->destination = other.destination;
+  this->payload = move(other.payload);
+  return *this;
 }
 
 /* --------------------------------------------------------------------------- */
 /* Function to print the contents of the Message's string to the screen. */
 /* --------------------------------------------------------------------------- */
 void Message::printMessage() {
-    cout << message <<endl;
+    cout.write(payload.data(), payload.size());
+    cout << endl;
 }
 
 /* --------------------------------------------------------------------------- */
@@ -49,3 +53,16 @@ int Message::getSource() {
   return source;
 }
 
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of characters in the Message's string. */
+/* --------------------------------------------------------------------------- */
+int Message::getLength() {
+  return payload.size();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the Message's Payload. */
+/* --------------------------------------------------------------------------- */
+const Payload &Message::getPayload() {
+  return payload;
+}
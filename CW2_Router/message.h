@@ -3,6 +3,8 @@
 
 #include <vector>
 
+#include "payload.h"
+
 using namespace std;
 
 class Message {
@@ -11,24 +13,32 @@ private:
 
   int destination; // int to keep track of a Message's destination Host.
 
-  char *message;   // Points to a dynamically allocated character array.
+  Payload payload; // The bytes of the message, shared with any other Message
+                   // made from the same Payload.
 
 public:
 
 /* --------------------------------------------------------------------------- */
 /* Constructor function for a Message. This requires a source Host int adress,
-   a destination Host int adress, and a character string for a message. It
-   dynamically allocates memory for a character array of the message string a 
-   Host wishes to send. */
+   a destination Host int adress, and a character string for a message, which
+   is copied into the Message's Payload. */
 /* --------------------------------------------------------------------------- */
   Message(int s, int d, const char *mess);
 
 /* --------------------------------------------------------------------------- */
-/* Destructor function for a Message. Since a Message dynamically allocates 
-   memory on the heap for the message string, the called destructor must delete
-   this memory, lest it create a memory leak. */
+/* Constructor function for a Message carrying an existing Payload, such as
+   one sent to many Hosts, without copying its bytes. */
 /* --------------------------------------------------------------------------- */
-  ~Message();
+  Message(int s, int d, const Payload &p);
+
+/* --------------------------------------------------------------------------- */
+/* A Message cannot be copied, only moved, so that there is one of it on its
+   way at a time. */
+/* --------------------------------------------------------------------------- */
+  Message(const Message &other) = delete;
+  Message &operator=(const Message &other) = delete;
+  Message(Message &&other);
+  Message &operator=(Message &&other);
 
 /* --------------------------------------------------------------------------- */
 /* Function to print the contents of the Message's string to the screen. */
@@ -44,6 +54,16 @@ public:
 /* Function to return the int address of the source Host. */
 /* --------------------------------------------------------------------------- */
   int getSource();
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of characters in the Message's string. */
+/* --------------------------------------------------------------------------- */
+  int getLength();
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the Message's Payload, to send on to another Host. */
+/* --------------------------------------------------------------------------- */
+  const Payload &getPayload();
 };
 
 #endif
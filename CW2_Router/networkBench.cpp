@@ -0,0 +1,466 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include "message.h"
+#include "host.h"
+#include "router.h"
+#include "simulator.h"
+#include "runtime.h"
+#include "generator.h"
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* Settings for a run of the benchmarks, from the command line. */
+/* --------------------------------------------------------------------------- */
+struct BenchSettings {
+	vector<TopologyKind> topologies;
+	vector<int> sizes;
+	vector<RoutingMode> modes;
+	TrafficKind traffic;
+	int degree;          // see NetworkGenerator::links().
+	int messages;        // Messages sent in each throughput test.
+	int payloadBytes;
+	int churn;           // links disconnected and reconnected one at a time.
+	unsigned int threads;
+	unsigned int seed;
+	bool json;
+};
+
+/* --------------------------------------------------------------------------- */
+/* Measurements of one network. Times are in milliseconds, and update counts
+   are those of UpdateQueue::getStats() (see propagation.h). */
+/* --------------------------------------------------------------------------- */
+struct BenchResult {
+	string topology;
+	int routers;
+	int links;
+	string mode;
+
+	double buildMs;          // connecting every link, and compiling every
+	long buildUpdates;       // forwarding table.
+	long buildRounds;
+
+	long routeEntries;       // routes in every routeMap,
+	long pathNodes;          // nodes storing them (see Path),
+	long forwardingEntries;  // and entries in every forwarding table.
+
+	double disconnectMs;     // means per link for the churn test.
+	double disconnectUpdates;
+	double connectMs;
+	double connectUpdates;
+
+	double sendPerSecond;    // Host::send(), delivering at once.
+
+	unsigned int runtimeThreads;
+	double runtimePerSecond; // Host::send() through a Runtime.
+	long runtimeDelivered;
+
+	double simulatorEventsPerSecond;
+	double simulatorMedianMs;    // simulated latency of delivered Messages.
+	double simulatorP99Ms;
+};
+
+/* --------------------------------------------------------------------------- */
+/* A stream buffer which throws away everything written to it, to stop Hosts
+   printing while their sending is timed. */
+/* --------------------------------------------------------------------------- */
+class NullBuffer : public streambuf {
+protected:
+	int overflow(int c) {
+		return c;
+	}
+};
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the milliseconds since a time. */
+/* --------------------------------------------------------------------------- */
+static double msSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to bring every Router's tables up to date, so that work put off
+   until routes are needed (in LINK_STATE mode) is counted where it is caused. */
+/* --------------------------------------------------------------------------- */
+static void converge(vector<Router *> &routers) {
+	for (unsigned int n = 0; n < routers.size(); n++) {
+		routers[n]->getForwardingSnapshot();
+	}
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the name of a routing mode. */
+/* --------------------------------------------------------------------------- */
+static const char *modeName(RoutingMode mode) {
+	if (mode == ALL_PATHS) {
+		return "all-paths";
+	}
+	if (mode == BEST_PATHS) {
+		return "best-paths";
+	}
+	return "link-state";
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to build one network and measure it. */
+/* --------------------------------------------------------------------------- */
+static BenchResult runCase(const BenchSettings &settings, TopologyKind kind, int size,
+                           RoutingMode mode) {
+	BenchResult result;
+	NetworkGenerator generator(settings.seed);
+	int count;
+	vector<pair<int, int> > links = generator.links(kind, size, settings.degree, count);
+	vector<pair<int, int> > traffic = generator.traffic(settings.traffic, count,
+	                                                    settings.messages);
+
+	result.topology = NetworkGenerator::topologyName(kind);
+	result.routers = count;
+	result.links = links.size();
+	result.mode = modeName(mode);
+
+	vector<Router *> routers;
+	vector<Host *> hosts;
+	for (int n = 0; n < count; n++) {
+		routers.push_back(new Router(n, mode));
+		hosts.push_back(new Host(n));
+		routers[n]->connectTo(*hosts[n]);
+	}
+
+	// Building the network.
+	UpdateQueue::resetStats();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (unsigned int n = 0; n < links.size(); n++) {
+		routers[links[n].first]->connectTo(*routers[links[n].second]);
+	}
+	converge(routers);
+	result.buildMs = msSince(start);
+	result.buildUpdates = UpdateQueue::getStats().updates;
+	result.buildRounds = UpdateQueue::getStats().rounds;
+
+	// Routing table memory.
+	result.routeEntries = 0;
+	result.forwardingEntries = 0;
+	for (int n = 0; n < count; n++) {
+		result.routeEntries += routers[n]->getRouteCount();
+		result.forwardingEntries += routers[n]->getForwardingSnapshot()->size();
+	}
+	result.pathNodes = Path::nodeCount();
+
+	// Taking links down and putting them back, one at a time.
+	double disconnect_ms = 0, connect_ms = 0;
+	long disconnect_updates = 0, connect_updates = 0;
+	int churned = 0;
+	for (int n = 0; (n < settings.churn) && !links.empty(); n++) {
+		pair<int, int> link = links[(n * 7919) % links.size()];
+		Router *a = routers[link.first];
+		Router *b = routers[link.second];
+
+		UpdateQueue::resetStats();
+		start = chrono::steady_clock::now();
+		a->disconnectFrom(*b);
+		converge(routers);
+		disconnect_ms += msSince(start);
+		disconnect_updates += UpdateQueue::getStats().updates;
+
+		UpdateQueue::resetStats();
+		start = chrono::steady_clock::now();
+		a->connectTo(*b);
+		converge(routers);
+		connect_ms += msSince(start);
+		connect_updates += UpdateQueue::getStats().updates;
+		churned++;
+	}
+	result.disconnectMs = (churned > 0) ? disconnect_ms / churned : 0;
+	result.disconnectUpdates = (churned > 0) ? (double) disconnect_updates / churned : 0;
+	result.connectMs = (churned > 0) ? connect_ms / churned : 0;
+	result.connectUpdates = (churned > 0) ? (double) connect_updates / churned : 0;
+
+	string bytes(settings.payloadBytes, 'x');
+	Payload payload(bytes.c_str());
+
+	// Sending with delivery at once, with the Hosts' printing thrown away.
+	NullBuffer nothing;
+	streambuf *screen = cout.rdbuf(&nothing);
+	start = chrono::steady_clock::now();
+	for (unsigned int n = 0; n < traffic.size(); n++) {
+		hosts[traffic[n].first]->send(traffic[n].second, payload);
+	}
+	double send_ms = msSince(start);
+	cout.rdbuf(screen);
+	result.sendPerSecond = (send_ms > 0) ? 1000 * traffic.size() / send_ms : 0;
+
+	// Sending through a Runtime.
+	{
+		Runtime runtime(settings.threads);
+		for (int n = 0; n < count; n++) {
+			runtime.attach(*routers[n]);
+		}
+		runtime.start();
+		start = chrono::steady_clock::now();
+		for (unsigned int n = 0; n < traffic.size(); n++) {
+			hosts[traffic[n].first]->send(traffic[n].second, payload);
+		}
+		runtime.wait();
+		double runtime_ms = msSince(start);
+		RuntimeStats stats = runtime.getStats();
+		result.runtimeThreads = settings.threads;
+		if (result.runtimeThreads == 0) {
+			result.runtimeThreads = thread::hardware_concurrency();
+		}
+		result.runtimePerSecond = (runtime_ms > 0) ? 1000 * traffic.size() / runtime_ms : 0;
+		result.runtimeDelivered = stats.delivered;
+	}
+
+	// Sending through a Simulator, one Message every microsecond.
+	{
+		Simulator simulator;
+		for (int n = 0; n < count; n++) {
+			hosts[n]->setSimulator(&simulator);
+		}
+		start = chrono::steady_clock::now();
+		for (unsigned int n = 0; n < traffic.size(); n++) {
+			simulator.runUntil(n * 1e-6);
+			hosts[traffic[n].first]->send(traffic[n].second, payload);
+		}
+		simulator.run();
+		double simulator_ms = msSince(start);
+		result.simulatorEventsPerSecond =
+		  (simulator_ms > 0) ? 1000 * simulator.getStats().events / simulator_ms : 0;
+		result.simulatorMedianMs = 1000 * simulator.latencyPercentile(0.5);
+		result.simulatorP99Ms = 1000 * simulator.latencyPercentile(0.99);
+		for (int n = 0; n < count; n++) {
+			hosts[n]->setSimulator(NULL);
+		}
+	}
+
+	for (int n = 0; n < count; n++) {
+		delete routers[n];
+	}
+	for (int n = 0; n < count; n++) {
+		delete hosts[n];
+	}
+	return result;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to print the results as CSV, with a header line, or as a JSON
+   array of objects with the same names. */
+/* --------------------------------------------------------------------------- */
+static const char *COLUMNS[] = {
+	"topology", "routers", "links", "mode",
+	"build_ms", "build_updates", "build_rounds",
+	"route_entries", "path_nodes", "forwarding_entries",
+	"disconnect_ms", "disconnect_updates", "connect_ms", "connect_updates",
+	"send_per_s", "runtime_threads", "runtime_per_s", "runtime_delivered",
+	"simulator_events_per_s", "simulator_median_ms", "simulator_p99_ms"
+};
+static const int COLUMN_COUNT = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+
+static string text(double value) {
+	ostringstream out;
+	out << value;
+	return out.str();
+}
+
+static vector<string> fields(const BenchResult &r) {
+	vector<string> f;
+	f.push_back(r.topology);
+	f.push_back(text(r.routers));
+	f.push_back(text(r.links));
+	f.push_back(r.mode);
+	f.push_back(text(r.buildMs));
+	f.push_back(text(r.buildUpdates));
+	f.push_back(text(r.buildRounds));
+	f.push_back(text(r.routeEntries));
+	f.push_back(text(r.pathNodes));
+	f.push_back(text(r.forwardingEntries));
+	f.push_back(text(r.disconnectMs));
+	f.push_back(text(r.disconnectUpdates));
+	f.push_back(text(r.connectMs));
+	f.push_back(text(r.connectUpdates));
+	f.push_back(text(r.sendPerSecond));
+	f.push_back(text(r.runtimeThreads));
+	f.push_back(text(r.runtimePerSecond));
+	f.push_back(text(r.runtimeDelivered));
+	f.push_back(text(r.simulatorEventsPerSecond));
+	f.push_back(text(r.simulatorMedianMs));
+	f.push_back(text(r.simulatorP99Ms));
+	return f;
+}
+
+static void printCsv(const vector<BenchResult> &results) {
+	for (int c = 0; c < COLUMN_COUNT; c++) {
+		cout << (c > 0 ? "," : "") << COLUMNS[c];
+	}
+	cout << endl;
+	for (unsigned int n = 0; n < results.size(); n++) {
+		vector<string> f = fields(results[n]);
+		for (unsigned int c = 0; c < f.size(); c++) {
+			cout << (c > 0 ? "," : "") << f[c];
+		}
+		cout << endl;
+	}
+}
+
+static void printJson(const vector<BenchResult> &results) {
+	cout << "[" << endl;
+	for (unsigned int n = 0; n < results.size(); n++) {
+		vector<string> f = fields(results[n]);
+		cout << "  {";
+		for (unsigned int c = 0; c < f.size(); c++) {
+			bool text = (c == 0) || (c == 3);
+			cout << (c > 0 ? ", " : "") << "\"" << COLUMNS[c] << "\": "
+			     << (text ? "\"" : "") << f[c] << (text ? "\"" : "");
+		}
+		cout << "}" << (n + 1 < results.size() ? "," : "") << endl;
+	}
+	cout << "]" << endl;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to split a comma-separated list. */
+/* --------------------------------------------------------------------------- */
+static vector<string> splitList(const string &list) {
+	vector<string> items;
+	istringstream in(list);
+	string item;
+	while (getline(in, item, ',')) {
+		if (!item.empty()) {
+			items.push_back(item);
+		}
+	}
+	return items;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to print how to run the benchmarks. */
+/* --------------------------------------------------------------------------- */
+static void printUsage() {
+	cout << "Usage: network_bench [options]" << endl
+	     << "  --topology LIST   line,ring,grid,erdos-renyi,barabasi-albert,fat-tree" << endl
+	     << "                    (default: all of them)" << endl
+	     << "  --size LIST       approximate numbers of routers (default: 16,64,256)" << endl
+	     << "  --mode LIST       all-paths,best-paths,link-state (default: best-paths)" << endl
+	     << "  --degree N        mean links per router for erdos-renyi, links per new" << endl
+	     << "                    router for barabasi-albert (default: 4)" << endl
+	     << "  --traffic KIND    uniform, permutation or hotspot (default: uniform)" << endl
+	     << "  --messages N      messages per throughput test (default: 10000)" << endl
+	     << "  --payload N       bytes per message (default: 64)" << endl
+	     << "  --churn N         links taken down and put back (default: 10)" << endl
+	     << "  --threads N       runtime worker threads, 0 for one per core (default: 0)" << endl
+	     << "  --seed N          (default: 1)" << endl
+	     << "  --json            print JSON instead of CSV" << endl
+	     << "all-paths keeps every loop-free route, so grows exponentially on meshes;" << endl
+	     << "keep it to small sizes. Build with optimization for meaningful times," << endl
+	     << "e.g. make network_bench CFLAGS=\"-O2 -MMD -pthread\"." << endl;
+}
+
+int main(int argc, char *argv[]) {
+	BenchSettings settings;
+	settings.traffic = UNIFORM;
+	settings.degree = 4;
+	settings.messages = 10000;
+	settings.payloadBytes = 64;
+	settings.churn = 10;
+	settings.threads = 0;
+	settings.seed = 1;
+	settings.json = 0;
+
+	for (int a = 1; a < argc; a++) {
+		string option = argv[a];
+		if (option == "--json") {
+			settings.json = 1;
+			continue;
+		}
+		if ((option == "--help") || (a + 1 >= argc)) {
+			printUsage();
+			return (option == "--help") ? 0 : 1;
+		}
+		string value = argv[++a];
+		vector<string> items = splitList(value);
+
+		if (option == "--topology") {
+			for (unsigned int n = 0; n < items.size(); n++) {
+				TopologyKind kind;
+				if (!NetworkGenerator::parseTopology(items[n], kind)) {
+					cout << "Sorry, there is no topology called " << items[n] << "." << endl;
+					return 1;
+				}
+				settings.topologies.push_back(kind);
+			}
+		} else if (option == "--size") {
+			for (unsigned int n = 0; n < items.size(); n++) {
+				settings.sizes.push_back(atoi(items[n].c_str()));
+			}
+		} else if (option == "--mode") {
+			for (unsigned int n = 0; n < items.size(); n++) {
+				if (items[n] == "all-paths") {
+					settings.modes.push_back(ALL_PATHS);
+				} else if (items[n] == "best-paths") {
+					settings.modes.push_back(BEST_PATHS);
+				} else if (items[n] == "link-state") {
+					settings.modes.push_back(LINK_STATE);
+				} else {
+					cout << "Sorry, there is no routing mode called " << items[n] << "." << endl;
+					return 1;
+				}
+			}
+		} else if (option == "--traffic") {
+			if (!NetworkGenerator::parseTraffic(value, settings.traffic)) {
+				cout << "Sorry, there is no traffic pattern called " << value << "." << endl;
+				return 1;
+			}
+		} else if (option == "--degree") {
+			settings.degree = atoi(value.c_str());
+		} else if (option == "--messages") {
+			settings.messages = atoi(value.c_str());
+		} else if (option == "--payload") {
+			settings.payloadBytes = atoi(value.c_str());
+		} else if (option == "--churn") {
+			settings.churn = atoi(value.c_str());
+		} else if (option == "--threads") {
+			settings.threads = atoi(value.c_str());
+		} else if (option == "--seed") {
+			settings.seed = atoi(value.c_str());
+		} else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (settings.topologies.empty()) {
+		for (int k = LINE; k <= FAT_TREE; k++) {
+			settings.topologies.push_back((TopologyKind) k);
+		}
+	}
+	if (settings.sizes.empty()) {
+		settings.sizes.push_back(16);
+		settings.sizes.push_back(64);
+		settings.sizes.push_back(256);
+	}
+	if (settings.modes.empty()) {
+		settings.modes.push_back(BEST_PATHS);
+	}
+
+	vector<BenchResult> results;
+	for (unsigned int m = 0; m < settings.modes.size(); m++) {
+		for (unsigned int t = 0; t < settings.topologies.size(); t++) {
+			for (unsigned int s = 0; s < settings.sizes.size(); s++) {
+				results.push_back(runCase(settings, settings.topologies[t],
+				                          settings.sizes[s], settings.modes[m]));
+			}
+		}
+	}
+
+	if (settings.json) {
+		printJson(results);
+	} else {
+		printCsv(results);
+	}
+	return 0;
+}
@@ -3,6 +3,8 @@
 #include "message.h"
 #include "host.h"
 #include "router.h"
+#include "simulator.h"
+#include "runtime.h"
 
 using namespace std;
 
@@ -59,6 +61,113 @@ int main()
  	r3.disconnectFrom(r5);
     
  	h3.send(5, "How many links must a packet walk down?");
+
+	// A ring of routers which keep only the best route to each host.
+	Router r11(11, BEST_PATHS), r12(12, BEST_PATHS), r13(13, BEST_PATHS), r14(14, BEST_PATHS);
+	Host h11(11), h14(14);
+	r11.connectTo(h11);
+	r14.connectTo(h14);
+	r11.connectTo(r12);
+	r12.connectTo(r13);
+	r13.connectTo(r14);
+	r14.connectTo(r11);
+
+	cout << "Best routes at Router 11:" << endl;
+	r11.printRoutingTable();
+	cout << endl;
+
+	r14.disconnectFrom(r11);
+
+	cout << "Best routes at Router 11 after Routers 11 and 14 disconnect:" << endl;
+	r11.printRoutingTable();
+	cout << endl;
+
+	h11.send(14, "The long way round");
+
+	// The same ring, with each router working out its own routes from the
+	// link-state advertisements of the others.
+	Router r21(21, LINK_STATE), r22(22, LINK_STATE), r23(23, LINK_STATE), r24(24, LINK_STATE);
+	Host h21(21), h24(24);
+	r21.connectTo(h21);
+	r24.connectTo(h24);
+	r21.connectTo(r22);
+	r22.connectTo(r23);
+	r23.connectTo(r24);
+	r24.connectTo(r21);
+
+	cout << "Link-state routes at Router 21:" << endl;
+	r21.printRoutingTable();
+	cout << endl;
+
+	r24.disconnectFrom(r21);
+
+	cout << "Link-state routes at Router 21 after Routers 21 and 24 disconnect:" << endl;
+	r21.printRoutingTable();
+	cout << endl;
+
+	h21.send(24, "Shortest path first");
+
+	// A line of routers, counting the rounds of updates it takes for the
+	// routes across the last link to reach every router.
+	Router r31(31, BEST_PATHS), r32(32, BEST_PATHS), r33(33, BEST_PATHS), r34(34, BEST_PATHS),
+	       r35(35, BEST_PATHS);
+	Host h31(31), h35(35);
+	r31.connectTo(h31);
+	r35.connectTo(h35);
+	r31.connectTo(r32);
+	r32.connectTo(r33);
+	r33.connectTo(r34);
+
+	UpdateQueue::resetStats();
+	r34.connectTo(r35);
+
+	const PropagationStats &stats = UpdateQueue::getStats();
+	cout << "Connecting Routers 34 and 35 took " << stats.rounds
+	     << " rounds of " << stats.updates << " updates, of which "
+	     << stats.accepted << " changed a routing table." << endl << endl;
+
+	// A burst of messages sent through a simulator, where the middle link is
+	// slower than the rest, so messages queue behind one another there.
+	Router r41(41, BEST_PATHS), r42(42, BEST_PATHS), r43(43, BEST_PATHS), r44(44, BEST_PATHS);
+	Host h41(41), h44(44);
+	r41.connectTo(h41);
+	r44.connectTo(h44);
+	r41.connectTo(r42);
+	r42.connectTo(r43);
+	r43.connectTo(r44);
+
+	Simulator sim(0.001, 1e8);
+	sim.setLink(r42, r43, 0.005, 1e6);
+	h41.setSimulator(&sim);
+	for (int n = 0; n < 10; n++) {
+		h41.send(44, "One of a burst of messages");
+	}
+	sim.run();
+	sim.printReport();
+
+	// The same messages forwarded by worker threads, each router passing them
+	// to the mailbox of the next.
+	Router r51(51, BEST_PATHS), r52(52, BEST_PATHS), r53(53, BEST_PATHS);
+	Host h51(51), h53(53);
+	r51.connectTo(h51);
+	r53.connectTo(h53);
+	r51.connectTo(r52);
+	r52.connectTo(r53);
+
+	// Every message shares the one payload, which is never copied.
+	Payload many("One of many messages, all carrying the same payload");
+
+	Runtime runtime(2);
+	runtime.attach(r51);
+	runtime.start();
+	for (int n = 0; n < 1000; n++) {
+		h51.send(53, many);
+	}
+	runtime.wait();
+
+	RuntimeStats runtime_stats = runtime.getStats();
+	cout << "The runtime delivered " << runtime_stats.delivered << " of "
+	     << runtime_stats.sent << " messages." << endl << endl;
 	
 	return 0;
 
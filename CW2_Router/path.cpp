@@ -0,0 +1,176 @@
+#include <vector>
+
+#include "path.h"
+
+using namespace std;
+
+vector<Path::Node> Path::nodes(1);
+vector<uint32_t> Path::unused;
+vector<uint32_t> Path::interned;
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the slot at which the search for a node starts: the hop
+   and rest mixed by Fibonacci hashing, as in the ForwardingTable. */
+/* --------------------------------------------------------------------------- */
+unsigned int Path::firstSlot(int hop, uint32_t rest) {
+  unsigned int hash = ((unsigned int) hop * 2654435769u) ^ (rest * 2246822519u);
+  hash *= 2654435769u;
+  return (hash ^ (hash >> 16)) & (interned.size() - 1);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to make the table of nodes large enough for one more, doubling it
+   and adding every node in use again if it is not. */
+/* --------------------------------------------------------------------------- */
+void Path::makeRoom() {
+  unsigned int count = nodeCount() + 1;
+  if (2 * count <= interned.size()) {
+    return;
+  }
+  unsigned int size = 8;
+  while (size < 4 * count) {
+    size *= 2;
+  }
+  interned.assign(size, 0);
+
+  unsigned int mask = size - 1;
+  for (uint32_t h = 1; h < nodes.size(); h++) {
+    if (nodes[h].refs == 0) {
+      continue;
+    }
+    unsigned int i = firstSlot(nodes[h].hop, nodes[h].rest);
+    while (interned[i] != 0) {
+      i = (i + 1) & mask;
+    }
+    interned[i] = h;
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the node for an entry in front of the rest of a route,
+   making one if there is none, and count a reference to it. */
+/* --------------------------------------------------------------------------- */
+uint32_t Path::intern(int hop, uint32_t rest) {
+  makeRoom();
+  unsigned int mask = interned.size() - 1;
+  unsigned int i = firstSlot(hop, rest);
+  for (; interned[i] != 0; i = (i + 1) & mask) {
+    Node &n = nodes[interned[i]];
+    if ((n.hop == hop) && (n.rest == rest)) {
+      n.refs++;
+      return interned[i];
+    }
+  }
+
+  Node n;
+  n.hop = hop;
+  n.rest = rest;
+  if (rest == 0) {
+    n.destination = hop;
+    n.length = 1;
+  } else {
+    n.destination = nodes[rest].destination;
+    n.length = nodes[rest].length + 1;
+    nodes[rest].refs++;
+  }
+  n.refs = 1;
+
+  uint32_t h;
+  if (unused.empty()) {
+    h = nodes.size();
+    nodes.push_back(n);
+  } else {
+    h = unused.back();
+    unused.pop_back();
+    nodes[h] = n;
+  }
+  interned[i] = h;
+  return h;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to drop a reference to a node, freeing it, and in turn dropping its
+   reference to the rest of its route, if it was the last. */
+/* --------------------------------------------------------------------------- */
+void Path::release(uint32_t h) {
+  unsigned int mask = interned.size() - 1;
+  while ((h != 0) && (--(nodes[h].refs) == 0)) {
+    unsigned int i = firstSlot(nodes[h].hop, nodes[h].rest);
+    while (interned[i] != h) {
+      i = (i + 1) & mask;
+    }
+
+    // Empty the slot, moving back any later node in the same run which would
+    // otherwise no longer be found from its first slot.
+    for (unsigned int j = (i + 1) & mask; interned[j] != 0; j = (j + 1) & mask) {
+      unsigned int k = firstSlot(nodes[interned[j]].hop, nodes[interned[j]].rest);
+      if (((j > i) && ((k <= i) || (k > j))) ||
+          ((j < i) && ((k <= i) && (k > j))))
+      {
+        interned[i] = interned[j];
+        i = j;
+      }
+    }
+    interned[i] = 0;
+
+    unused.push_back(h);
+    h = nodes[h].rest;
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Constructor functions for a route to a Host connected directly, and a route
+   with a Router in front of another route. */
+/* --------------------------------------------------------------------------- */
+Path::Path(int host) : handle(intern(host, 0)) {}
+
+Path::Path(int router, const Path &rest) : handle(intern(router, rest.handle)) {}
+
+/* --------------------------------------------------------------------------- */
+/* Function to check whether the route passes through a Router. */
+/* --------------------------------------------------------------------------- */
+bool Path::contains(int router) const {
+  // The last node is the Host, so is not checked.
+  for (uint32_t h = handle; (h != 0) && (nodes[h].rest != 0); h = nodes[h].rest) {
+    if (nodes[h].hop == router) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to check whether the route passes along the link between two
+   Routers, in either direction. */
+/* --------------------------------------------------------------------------- */
+bool Path::usesLink(int router1, int router2) const {
+  int prev_num = -999;
+  for (uint32_t h = handle; (h != 0) && (nodes[h].rest != 0); h = nodes[h].rest) {
+    int num = nodes[h].hop;
+    if (((router1 == num) && (router2 == prev_num)) ||
+        ((router2 == num) && (router1 == prev_num)))
+    {
+      return 1;
+    }
+    prev_num = num;
+  }
+  return 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the entries of the route in order. */
+/* --------------------------------------------------------------------------- */
+vector<int> Path::entries() const {
+  vector<int> v;
+  for (uint32_t h = handle; h != 0; h = nodes[h].rest) {
+    v.push_back(nodes[h].hop);
+  }
+  return v;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of nodes in use by all routes. */
+/* --------------------------------------------------------------------------- */
+unsigned int Path::nodeCount() {
+  return nodes.size() - 1 - unused.size();
+}
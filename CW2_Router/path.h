@@ -0,0 +1,141 @@
+#ifndef PATH_H
+#define PATH_H
+#include <vector>
+#include <stdint.h>
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* A route [router, ..., router, host] is kept as a chain of nodes, one for each
+   entry, each pointing to the node for the rest of the route. There is only
+   ever one node for a given entry and rest, so a route with a Router put in
+   front shares every node of the route it was made from, equal routes are the
+   same node, and the routes of a whole network cost one node for each distinct
+   route rather than one int for each entry of each route. A Path is a 32-bit
+   handle to a node; nodes count the Paths and nodes which refer to them, and
+   are reused once there are none. */
+/* --------------------------------------------------------------------------- */
+class Path {
+private:
+  struct Node {
+    int hop;              // first entry of the route.
+    uint32_t rest;        // node for the rest of the route, or 0 if hop is the
+                          // Host at the end.
+    int destination;      // the Host at the end of the route.
+    unsigned int length;  // number of entries in the route.
+    unsigned int refs;    // Paths and nodes referring to this node.
+  };
+
+  static vector<Node> nodes;          // nodes[0] is unused, so that 0 means
+                                      // no route.
+
+  static vector<uint32_t> unused;     // nodes free for reuse.
+
+  static vector<uint32_t> interned;   // Every node in use, found by its hop and
+                                      // rest: open addressing with linear
+                                      // probing, 0 marking an empty slot. The
+                                      // number of slots is a power of two, at
+                                      // least twice the number of nodes.
+
+  uint32_t handle;
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the slot at which the search for a node starts. */
+/* --------------------------------------------------------------------------- */
+  static unsigned int firstSlot(int hop, uint32_t rest);
+
+/* --------------------------------------------------------------------------- */
+/* Function to make the table of nodes large enough for one more. */
+/* --------------------------------------------------------------------------- */
+  static void makeRoom();
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the node for an entry in front of the rest of a route,
+   making one if there is none, and count a reference to it. */
+/* --------------------------------------------------------------------------- */
+  static uint32_t intern(int hop, uint32_t rest);
+
+/* --------------------------------------------------------------------------- */
+/* Function to drop a reference to a node, freeing it, and in turn dropping its
+   reference to the rest of its route, if it was the last. */
+/* --------------------------------------------------------------------------- */
+  static void release(uint32_t h);
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor functions for no route, a route to a Host connected directly,
+   and a route with a Router in front of another route. */
+/* --------------------------------------------------------------------------- */
+  Path() : handle(0) {}
+  explicit Path(int host);
+  Path(int router, const Path &rest);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to copy, move and destroy a Path, keeping count of the references
+   to its node. */
+/* --------------------------------------------------------------------------- */
+  Path(const Path &p) : handle(p.handle) {
+    if (handle != 0) {
+      nodes[handle].refs++;
+    }
+  }
+  Path(Path &&p) : handle(p.handle) {
+    p.handle = 0;
+  }
+  Path &operator=(Path p) {
+    uint32_t h = handle;
+    handle = p.handle;
+    p.handle = h;
+    return *this;
+  }
+  ~Path() {
+    if (handle != 0) {
+      release(handle);
+    }
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to compare two routes. Since equal routes share a node, this is a
+   comparison of handles. */
+/* --------------------------------------------------------------------------- */
+  bool operator==(const Path &p) const {
+    return handle == p.handle;
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the first entry of the route, the Host at its end, and
+   the number of entries in it. */
+/* --------------------------------------------------------------------------- */
+  int first() const {
+    return nodes[handle].hop;
+  }
+  int destination() const {
+    return nodes[handle].destination;
+  }
+  unsigned int size() const {
+    return (handle == 0) ? 0 : nodes[handle].length;
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to check whether the route passes through a Router. */
+/* --------------------------------------------------------------------------- */
+  bool contains(int router) const;
+
+/* --------------------------------------------------------------------------- */
+/* Function to check whether the route passes along the link between two
+   Routers, in either direction. */
+/* --------------------------------------------------------------------------- */
+  bool usesLink(int router1, int router2) const;
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the entries of the route in order. */
+/* --------------------------------------------------------------------------- */
+  vector<int> entries() const;
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of nodes in use by all routes. */
+/* --------------------------------------------------------------------------- */
+  static unsigned int nodeCount();
+};
+
+#endif
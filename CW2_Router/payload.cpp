@@ -0,0 +1,199 @@
+#include <cstring>
+#include <new>
+#include <atomic>
+#include <mutex>
+
+#include "payload.h"
+
+using namespace std;
+
+// Most blocks of each size a thread keeps; past this, BATCH of them are passed
+// to the shared lists. A thread with none takes up to BATCH from there.
+static const unsigned int CACHE_LIMIT = 256;
+static const unsigned int BATCH = 128;
+
+thread_local Payload::Cache Payload::cache;
+mutex Payload::sharedLock;
+Payload::FreeBlock *Payload::shared[Payload::SIZES];
+unsigned int Payload::sharedCount[Payload::SIZES];
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for a thread's Cache, which starts empty. */
+/* --------------------------------------------------------------------------- */
+Payload::Cache::Cache() {
+  for (int s = 0; s < SIZES; s++) {
+    blocks[s] = NULL;
+    count[s] = 0;
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Destructor function for a thread's Cache, passing its blocks to the shared
+   lists when the thread ends. */
+/* --------------------------------------------------------------------------- */
+Payload::Cache::~Cache() {
+  lock_guard<mutex> guard(sharedLock);
+  for (int s = 0; s < SIZES; s++) {
+    while (blocks[s] != NULL) {
+      FreeBlock *f = blocks[s];
+      blocks[s] = f->next;
+      f->next = shared[s];
+      shared[s] = f;
+      sharedCount[s]++;
+    }
+    count[s] = 0;
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to get a block with room for the given number of bytes: from the
+   thread's own blocks, then from the shared lists, then newly allocated. */
+/* --------------------------------------------------------------------------- */
+Payload::Block *Payload::allocate(int bytes) {
+  unsigned int needed = sizeof(Block) + bytes;
+  int s = 0;
+  unsigned int block_size = SMALLEST_BLOCK;
+  while ((s < SIZES) && (block_size < needed)) {
+    s++;
+    block_size *= 2;
+  }
+
+  void *memory;
+  if (s == SIZES) {
+    memory = ::operator new(needed);
+    s = -1;
+  } else {
+    if (cache.blocks[s] == NULL) {
+      lock_guard<mutex> guard(sharedLock);
+      for (unsigned int n = 0; (n < BATCH) && (shared[s] != NULL); n++) {
+        FreeBlock *f = shared[s];
+        shared[s] = f->next;
+        sharedCount[s]--;
+        f->next = cache.blocks[s];
+        cache.blocks[s] = f;
+        cache.count[s]++;
+      }
+    }
+    if (cache.blocks[s] != NULL) {
+      FreeBlock *f = cache.blocks[s];
+      cache.blocks[s] = f->next;
+      cache.count[s]--;
+      memory = f;
+    } else {
+      memory = ::operator new(block_size);
+    }
+  }
+
+  Block *b = static_cast<Block *>(memory);
+  new (&(b->refs)) atomic<int>(1);
+  b->size = s;
+  return b;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to give back a block once no Payload uses it, keeping it for reuse
+   by the thread unless it has too many. */
+/* --------------------------------------------------------------------------- */
+void Payload::recycle(Block *b) {
+  int s = b->size;
+  if (s < 0) {
+    ::operator delete(b);
+    return;
+  }
+
+  FreeBlock *f = reinterpret_cast<FreeBlock *>(b);
+  f->next = cache.blocks[s];
+  cache.blocks[s] = f;
+  cache.count[s]++;
+  if (cache.count[s] > CACHE_LIMIT) {
+    lock_guard<mutex> guard(sharedLock);
+    for (unsigned int n = 0; n < BATCH; n++) {
+      FreeBlock *moving = cache.blocks[s];
+      cache.blocks[s] = moving->next;
+      cache.count[s]--;
+      moving->next = shared[s];
+      shared[s] = moving;
+      sharedCount[s]++;
+    }
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to drop this Payload's reference to its block, if it has one. */
+/* --------------------------------------------------------------------------- */
+void Payload::release() {
+  if ((block != NULL) && ((block->refs).fetch_sub(1, memory_order_acq_rel) == 1)) {
+    recycle(block);
+  }
+  block = NULL;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Constructor functions for an empty Payload, and for one holding a copy of
+   a string, or of a number of bytes. */
+/* --------------------------------------------------------------------------- */
+Payload::Payload() : block(NULL), length(0) {}
+
+Payload::Payload(const char *text) : Payload(text, strlen(text)) {}
+
+Payload::Payload(const char *data, int count) : block(NULL), length(count) {
+  if (count <= INLINE_BYTES) {
+    memcpy(text, data, count);
+    return;
+  }
+  block = allocate(count);
+  char *start = reinterpret_cast<char *>(block + 1);
+  memcpy(start, data, count);
+  bytes = start;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Copy and move constructor functions. */
+/* --------------------------------------------------------------------------- */
+Payload::Payload(const Payload &other) : block(other.block), length(other.length) {
+  // The bytes kept inside, or the pointer to those in the block, are copied
+  // whole, which is quicker than copying only as many as there are.
+  memcpy(text, other.text, INLINE_BYTES);
+  if (block != NULL) {
+    (block->refs).fetch_add(1, memory_order_relaxed);
+  }
+}
+
+Payload::Payload(Payload &&other) : block(other.block), length(other.length) {
+  memcpy(text, other.text, INLINE_BYTES);
+  other.block = NULL;
+  other.length = 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to make a Payload hold the same bytes as another. The other has
+   already been copied or moved into the argument. */
+/* --------------------------------------------------------------------------- */
+Payload &Payload::operator=(Payload other) {
+  release();
+  block = other.block;
+  length = other.length;
+  memcpy(text, other.text, INLINE_BYTES);
+  other.block = NULL;
+  return *this;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Destructor function for a Payload. */
+/* --------------------------------------------------------------------------- */
+Payload::~Payload() {
+  release();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return a Payload holding part of this one's bytes. */
+/* --------------------------------------------------------------------------- */
+Payload Payload::slice(int offset, int count) const {
+  if (block == NULL) {
+    return Payload(text + offset, count);
+  }
+  Payload part(*this);
+  part.bytes += offset;
+  part.length = count;
+  return part;
+}
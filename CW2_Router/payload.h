@@ -0,0 +1,114 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* The bytes carried by a Message, which are never changed once made. Short
+   payloads are kept inside the Payload itself. Longer ones are kept in a
+   block, counted by reference, which every copy of the Payload shares, so
+   copying a Payload, or taking a slice of it, does not copy the bytes. Blocks
+   come in a few sizes and are reused: each thread keeps the blocks it frees
+   for the next payloads it makes, passing them on to other threads in batches
+   when it has too many. */
+/* --------------------------------------------------------------------------- */
+class Payload {
+private:
+  static const int INLINE_BYTES = 24;  // longest payload kept inside.
+
+  static const int SIZES = 7;          // sizes of block, from SMALLEST_BLOCK
+  static const int SMALLEST_BLOCK = 64;// bytes doubling each time. Longer
+                                       // payloads get a block of their own.
+
+  struct Block {
+    atomic<int> refs;    // Payloads sharing the block.
+    int size;            // which size of block, or -1 if it is not reused.
+  };                     // The bytes follow.
+
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  // Blocks freed by one thread and not yet reused, of each size.
+  struct Cache {
+    FreeBlock *blocks[SIZES];
+    unsigned int count[SIZES];
+    Cache();
+    ~Cache();
+  };
+
+  static thread_local Cache cache;
+
+  static mutex sharedLock;            // guards the blocks passed between
+  static FreeBlock *shared[SIZES];    // threads, of each size.
+  static unsigned int sharedCount[SIZES];
+
+  Block *block;          // NULL if the bytes are kept inside.
+  union {
+    const char *bytes;   // start of the bytes in the block.
+    char text[INLINE_BYTES];
+  };
+  int length;
+
+/* --------------------------------------------------------------------------- */
+/* Functions to get a block with room for the given number of bytes, and to
+   give one back once no Payload uses it. */
+/* --------------------------------------------------------------------------- */
+  static Block *allocate(int bytes);
+  static void recycle(Block *b);
+
+/* --------------------------------------------------------------------------- */
+/* Function to drop this Payload's reference to its block, if it has one. */
+/* --------------------------------------------------------------------------- */
+  void release();
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor functions for an empty Payload, and for one holding a copy of
+   a string, or of a number of bytes. */
+/* --------------------------------------------------------------------------- */
+  Payload();
+  Payload(const char *text);
+  Payload(const char *data, int count);
+
+/* --------------------------------------------------------------------------- */
+/* Copy and move constructor functions. A copy shares the block of the
+   Payload it is copied from. */
+/* --------------------------------------------------------------------------- */
+  Payload(const Payload &other);
+  Payload(Payload &&other);
+
+/* --------------------------------------------------------------------------- */
+/* Function to make a Payload hold the same bytes as another. */
+/* --------------------------------------------------------------------------- */
+  Payload &operator=(Payload other);
+
+/* --------------------------------------------------------------------------- */
+/* Destructor function for a Payload, giving back its block if it was the last
+   to use it. */
+/* --------------------------------------------------------------------------- */
+  ~Payload();
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the bytes, which are not followed by a NUL, and how
+   many there are. */
+/* --------------------------------------------------------------------------- */
+  const char *data() const {
+    return (block != NULL) ? bytes : text;
+  }
+
+  int size() const {
+    return length;
+  }
+
+/* --------------------------------------------------------------------------- */
+/* Function to return a Payload holding part of this one's bytes, sharing its
+   block. The part must lie within the bytes. */
+/* --------------------------------------------------------------------------- */
+  Payload slice(int offset, int count) const;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include <vector>
+#include <algorithm>
+
+#include "propagation.h"
+#include "router.h"
+
+using namespace std;
+
+PropagationStats UpdateQueue::stats = {0, 0, 0, 0, 0, vector<PropagationRound>()};
+unsigned int UpdateQueue::logLimit = 0;
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for an empty UpdateQueue. */
+/* --------------------------------------------------------------------------- */
+UpdateQueue::UpdateQueue() {
+  PropagationRound empty = {0, 0, 0, 0};
+  round = empty;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the batch waiting at a Router, starting one if there is
+   none, and count the update being added to it. */
+/* --------------------------------------------------------------------------- */
+UpdateQueue::Batch &UpdateQueue::batchFor(Router *r) {
+  round.updates++;
+  unordered_map<Router *, int>::iterator found = position.find(r);
+  if (found != position.end()) {
+    round.coalesced++;
+    return waiting[found->second].second;
+  }
+  position[r] = waiting.size();
+  waiting.push_back(pair<Router *, Batch>(r, Batch()));
+  round.routers++;
+  return waiting.back().second;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to add an update for a Router: a route offered to it, a Host it
+   can no longer reach, or a link between two Routers which is gone. Repeats
+   of a Host or link already in the batch are dropped, as are routes which
+   already pass through the Router, since it would only refuse them. */
+/* --------------------------------------------------------------------------- */
+void UpdateQueue::offerRoute(Router *r, const Path &route) {
+  if (route.contains(r->getNumber())) {
+    return;
+  }
+  batchFor(r).routes.push_back(route);
+}
+
+void UpdateQueue::withdrawHost(Router *r, int host) {
+  vector<int> &hosts = batchFor(r).hosts;
+  if (find(hosts.begin(), hosts.end(), host) == hosts.end()) {
+    hosts.push_back(host);
+  } else {
+    round.coalesced++;
+  }
+}
+
+void UpdateQueue::withdrawLink(Router *r, int num_router1, int num_router2) {
+  vector<pair<int, int> > &links = batchFor(r).links;
+  pair<int, int> link(min(num_router1, num_router2), max(num_router1, num_router2));
+  if (find(links.begin(), links.end(), link) == links.end()) {
+    links.push_back(link);
+  } else {
+    round.coalesced++;
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to deliver updates round by round until none are left. */
+/* --------------------------------------------------------------------------- */
+void UpdateQueue::run() {
+  vector<pair<Router *, Batch> > current;
+  PropagationRound empty = {0, 0, 0, 0};
+
+  while (!waiting.empty()) {
+    // Take the waiting batches as this round; updates they cause wait for the
+    // next.
+    current.swap(waiting);
+    waiting.clear();
+    position.clear();
+    PropagationRound counts = round;
+    round = empty;
+
+    for (unsigned int n = 0; n < current.size(); n++) {
+      counts.accepted += (current[n].first)->processUpdates(current[n].second, *this);
+    }
+    current.clear();
+    addRound(counts);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to note that a Router removed routes over a link which is gone,
+   and to take the list of such Routers noted so far. */
+/* --------------------------------------------------------------------------- */
+void UpdateQueue::noteLostRoutes(Router *r) {
+  lost.push_back(r);
+}
+
+vector<Router *> UpdateQueue::takeLostRoutes() {
+  vector<Router *> taken;
+  taken.swap(lost);
+  return taken;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to add a round counted elsewhere, and to read and reset the counts
+   of every round run since the last reset. */
+/* --------------------------------------------------------------------------- */
+void UpdateQueue::addRound(const PropagationRound &r) {
+  stats.rounds++;
+  stats.updates += r.updates;
+  stats.coalesced += r.coalesced;
+  stats.accepted += r.accepted;
+  stats.busiestRound = max(stats.busiestRound, r.routers);
+  if (stats.log.size() < logLimit) {
+    stats.log.push_back(r);
+  }
+}
+
+const PropagationStats &UpdateQueue::getStats() {
+  return stats;
+}
+
+void UpdateQueue::resetStats() {
+  stats.rounds = 0;
+  stats.updates = 0;
+  stats.coalesced = 0;
+  stats.accepted = 0;
+  stats.busiestRound = 0;
+  stats.log.clear();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to keep the counts of each of the first limit rounds after every
+   reset, as well as the totals. */
+/* --------------------------------------------------------------------------- */
+void UpdateQueue::logRounds(unsigned int limit) {
+  logLimit = limit;
+  if (stats.log.size() > limit) {
+    stats.log.resize(limit);
+  }
+  stats.log.shrink_to_fit();
+}
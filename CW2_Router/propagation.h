@@ -0,0 +1,115 @@
+#ifndef PROPAGATION_H
+#define PROPAGATION_H
+#include <vector>
+#include <unordered_map>
+
+#include "path.h"
+
+using namespace std;
+
+class Router;
+
+/* --------------------------------------------------------------------------- */
+/* Counts for one round of propagation, in which every Router with updates
+   waiting deals with all of them at once. */
+/* --------------------------------------------------------------------------- */
+struct PropagationRound {
+  int routers;      // Routers which had updates waiting.
+  long updates;     // updates delivered to them.
+  long coalesced;   // updates which joined a batch already waiting at the
+                    // same Router, or repeated one in it.
+  long accepted;    // updates which changed a Router's tables.
+};
+
+/* --------------------------------------------------------------------------- */
+/* Totals for every round since the counts were last reset. The counts of each
+   round are only kept in log if UpdateQueue::logRounds() asked for them, since
+   building a long chain of Routers takes millions of rounds. */
+/* --------------------------------------------------------------------------- */
+struct PropagationStats {
+  long rounds;
+  long updates;
+  long coalesced;
+  long accepted;
+  int busiestRound;                 // most Routers updated in one round.
+  vector<PropagationRound> log;
+};
+
+class UpdateQueue {
+public:
+  // The updates waiting at one Router.
+  struct Batch {
+    vector<Path> routes;              // routes offered by neighbors.
+    vector<int> hosts;                // Hosts no longer reachable.
+    vector<pair<int, int> > links;    // links between Routers which are gone.
+  };
+
+private:
+  vector<pair<Router *, Batch> > waiting;  // Routers with updates for the next
+                                           // round, in order of their first
+                                           // update.
+
+  unordered_map<Router *, int> position;   // Router -> index in waiting.
+
+  PropagationRound round;                  // Counts for the next round.
+
+  vector<Router *> lost;                   // Routers which removed routes
+                                           // over a link which is gone, in
+                                           // the order they did so.
+
+  static PropagationStats stats;
+
+  static unsigned int logLimit;            // most rounds kept in stats.log.
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the batch waiting at a Router, starting one if there is
+   none, and count the update being added to it. */
+/* --------------------------------------------------------------------------- */
+  Batch &batchFor(Router *r);
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for an empty UpdateQueue. */
+/* --------------------------------------------------------------------------- */
+  UpdateQueue();
+
+/* --------------------------------------------------------------------------- */
+/* Functions to add an update for a Router: a route offered to it, a Host it
+   can no longer reach, or a link between two Routers which is gone. */
+/* --------------------------------------------------------------------------- */
+  void offerRoute(Router *r, const Path &route);
+  void withdrawHost(Router *r, int host);
+  void withdrawLink(Router *r, int num_router1, int num_router2);
+
+/* --------------------------------------------------------------------------- */
+/* Function to deliver updates round by round until none are left. Each Router
+   deals with its whole batch in one go (see Router::processUpdates()), adding
+   any updates it causes to the next round. Uses no recursion, so it is safe
+   however long the chains of Routers. */
+/* --------------------------------------------------------------------------- */
+  void run();
+
+/* --------------------------------------------------------------------------- */
+/* Functions to note that a Router removed routes over a link which is gone,
+   and to take the list of such Routers (which may repeat) noted so far. */
+/* --------------------------------------------------------------------------- */
+  void noteLostRoutes(Router *r);
+  vector<Router *> takeLostRoutes();
+
+/* --------------------------------------------------------------------------- */
+/* Functions to add a round counted elsewhere (such as a link-state flood), and
+   to read and reset the counts of every round run since the last reset. */
+/* --------------------------------------------------------------------------- */
+  static void addRound(const PropagationRound &r);
+  static const PropagationStats &getStats();
+  static void resetStats();
+
+/* --------------------------------------------------------------------------- */
+/* Function to keep the counts of each of the first limit rounds after every
+   reset in PropagationStats::log, as well as the totals. The default, 0, keeps
+   none. */
+/* --------------------------------------------------------------------------- */
+  static void logRounds(unsigned int limit);
+};
+
+#endif
@@ -2,6 +2,9 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <deque>
+#include <algorithm>
 
 #include "router.h"
 #include "host.h"
@@ -11,9 +14,34 @@
 using namespace std;
 
 /* --------------------------------------------------------------------------- */
-/* Constructor function for Router. */
+/* Function to order routes by length, for stable_sort(). */
 /* --------------------------------------------------------------------------- */
-Router::Router(int n) : number(n), asked(0) {}
+static bool shorterRoute(const Path &a, const Path &b) {
+  return a.size() < b.size();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for Router, choosing how it keeps routes. */
+/* --------------------------------------------------------------------------- */
+Router::Router(int n, RoutingMode mode, int paths)
+  : routingMode(mode), pathsKept(paths), number(n), linkStateSequence(0),
+    routesStale(0), forwardingStale(0) {
+  if (paths < 1) {
+    cout << "Sorry, a router must keep at least one route to each host." << endl;
+    this->pathsKept = 1;
+  }
+  this->topology = new Topology(this);
+  this->forwarding = make_shared<const ForwardingTable>();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Destructor function for Router, removing it from its network's Topology. */
+/* --------------------------------------------------------------------------- */
+Router::~Router() {
+  if ((this->topology)->removeRouter(this)) {
+    delete this->topology;
+  }
+}
 
 /* --------------------------------------------------------------------------- */
 /* Function to return the int number of the Router. */
@@ -22,13 +50,35 @@ int Router::getNumber() {
   return this->number;
 }
 
-bool Router::getAsked() {
-  return this->asked;
+/* --------------------------------------------------------------------------- */
+/* Functions to return and reset the Topology of the Router's network. */
+/* --------------------------------------------------------------------------- */
+Topology *Router::getTopology() {
+  return this->topology;
 }
 
-void Router::setAsked(bool a) {
-  this->asked = a;
+void Router::setTopology(Topology *t) {
+  this->topology = t;
 }
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the Router's neighboring Routers and Hosts tables. */
+/* --------------------------------------------------------------------------- */
+const multimap<int, Router *> &Router::getNeighborRouters() {
+  return this->neighborRouters;
+}
+
+const multimap<int, Host *> &Router::getNeighborHosts() {
+  return this->neighborHosts;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the Router's routing mode. */
+/* --------------------------------------------------------------------------- */
+RoutingMode Router::getRoutingMode() {
+  return this->routingMode;
+}
+
 /* --------------------------------------------------------------------------- */
 /* Function to Connect two Routers together by swapping their route tables:
    the function checks for various invalid scenarios, then updates the routers'
@@ -50,6 +100,15 @@ void Router::connectTo(Router &r) {
          << "address, so cannot connect." << endl;
     return;
   }
+
+  // Check to see if the Routers keep routes in different ways, as they could
+  // not make sense of each other's updates.
+  if (other_router->routingMode != this->routingMode) {
+    cout << "Sorry, Router " << this->getNumber() << " and Router "
+         << other_router->getNumber() << " use different routing modes, so "
+         << "cannot connect." << endl;
+    return;
+  }
   
   // Now check to see if two separate networks are attempting to connect to 
   // each other, but contain Routers with the same network addresses. 
@@ -57,9 +116,6 @@ void Router::connectTo(Router &r) {
   if (this->checkIfNetworkCombineSameRouters(other_router)) {
     return;
   }
-  if (other_router->checkIfNetworkCombineSameRouters(this)) {
-    return;
-  }
 
   // Now check to see if two separate networks are attempting to connect to 
   // each other, but each ontain a Host with the same network address.
@@ -75,11 +131,25 @@ void Router::connectTo(Router &r) {
   (other_router->neighborRouters).insert(
 					 pair<int, Router*>
 					 (this->getNumber(), this));
+  Topology::join(this, other_router);
+
+  // In LINK_STATE mode, each Router advertises its new connection, and the two
+  // exchange databases so that both networks learn of each other.
+  if (this->routingMode == LINK_STATE) {
+    this->originateLinkState();
+    other_router->originateLinkState();
+    floodLinkStates(other_router, this, (this->linkStates).contents());
+    floodLinkStates(this, other_router, (other_router->linkStates).contents());
+    return;
+  }
 
-  this->transmitRoutes();
-
-  other_router->transmitRoutes();
-
+  // The other Router offers its routes once it has taken this one's, so that it
+  // does not offer routes which they replace.
+  UpdateQueue queue;
+  this->offerRoutes(queue);
+  queue.run();
+  other_router->offerRoutes(queue);
+  queue.run();
 }
 
 /* --------------------------------------------------------------------------- */
@@ -87,17 +157,26 @@ void Router::connectTo(Router &r) {
    in its neighborTable. */
 /* --------------------------------------------------------------------------- */
 void Router::transmitRoutes() {
-  for (multimap<int, vector<int> >::iterator i = (this->routeMap).begin();
+  UpdateQueue queue;
+  this->offerRoutes(queue);
+  queue.run();
+}
+
+/* --------------------------------------------------------------------------- */
+/* This function adds to a queue the offer of every route in the Router's 
+   routeMap, with the Router in front, to each of its neighbor Routers. */
+/* --------------------------------------------------------------------------- */
+void Router::offerRoutes(UpdateQueue &queue) {
+  for (multimap<int, Path>::iterator i = (this->routeMap).begin();
        i != (this->routeMap).end();
        i++) 
   {
-    vector<int> route = i->second;
-    route.insert(route.begin(), this->getNumber());
+    Path route(this->getNumber(), i->second);
     for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
 	 ri != (this->neighborRouters).end();
          ri++) 
     {
-      this->updateNeighbor(ri->second, route);
+      queue.offerRoute(ri->second, route);
     }
   }
 }
@@ -106,46 +185,311 @@ void Router::transmitRoutes() {
 /* This function sends a route to a Router, which then checks the route before 
    adding the route to its routeMap. */
 /* --------------------------------------------------------------------------- */
-void Router::updateNeighbor(Router *r, vector<int> v) {
+void Router::updateNeighbor(Router *r, const Path &v) {
+  UpdateQueue queue;
+  queue.offerRoute(r, v);
+  queue.run();
+}
 
-  // First, we check the route to see if the Router is included, if so the call 
-  // ends. This ensures that the process of transmitting routes terminates. 
-  for(vector<int>::iterator i = v.begin();
-      i != v.end() - 1; // Since the routes include a Host as final entry, need 
-                        // to terminate loop BEFORE final entry is checked. 
-      i++)
+/* --------------------------------------------------------------------------- */
+/* Function to check whether a route is already in the Router's routeMap. */
+/* --------------------------------------------------------------------------- */
+bool Router::hasRoute(const Path &v) {
+  pair<multimap<int, Path>::iterator, 
+       multimap<int, Path>::iterator> range;
+  range = (this->routeMap).equal_range(v.destination());
+
+  for (multimap<int, Path>::iterator i = range.first;
+       i != range.second;
+       i++) 
   {
-    if (*i == r->getNumber()) {
-      return; 
-    }
+    if (i->second == v) return 1;
+  }
+  return 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* This function checks a route offered by a neighbor and adds it to the 
+   Router's routeMap if it should be kept. Returns TRUE if it was added. */
+/* --------------------------------------------------------------------------- */
+bool Router::acceptRoute(const Path &v) {
+  // First, we check the route to see if the Router is included, if so the route
+  // is refused. This ensures that the process of transmitting routes 
+  // terminates. 
+  if (v.contains(this->getNumber())) {
+    return 0; 
   }
   
-  // Second, we check the exisiting routeMap for exact copies of the route, 
-  // if so the call ends. This prevents multiple copies of the same route in a 
-  // router's routeMap.
-  pair<multimap<int,vector<int> >::iterator, 
-       multimap<int,vector<int> >::iterator> range;
-  range = (r->routeMap).equal_range(*(v.end()-1));
-
-  for (multimap<int,vector<int> >::iterator i = range.first;
+  // Second, we check the exisiting routeMap for exact copies of the route. 
+  // This prevents multiple copies of the same route in a router's routeMap.
+  if (this->hasRoute(v)) {
+    return 0;
+  }
+
+  // In BEST_PATHS mode, a route is only kept, and passed on, if it is one of 
+  // the shortest routes the Router knows to the Host.
+  if ((this->routingMode == BEST_PATHS) && !(this->makeRoomForRoute(v))) {
+    return 0;
+  }
+
+  // Finally, we add the route to the Router's routeMap in the form:
+  // <Host id, route>.
+  (this->routeMap).insert(pair<int, Path>(v.destination(), v));
+  this->forwardingStale = 1;
+  return 1;
+}
+
+/* --------------------------------------------------------------------------- */
+/* This function deals with a batch of updates from an UpdateQueue: links which 
+   are gone, Hosts which are gone, and routes offered. Updates which change the
+   Router's routeMap are passed on to its neighbors through the queue. Returns
+   the number of updates which changed the routeMap. */
+/* --------------------------------------------------------------------------- */
+int Router::processUpdates(UpdateQueue::Batch &batch, UpdateQueue &queue) {
+  int changes = 0;
+
+  // Remove every route which passes along a link which is gone. If any were
+  // removed, the Router's neighbors may have such routes too.
+  if (!batch.links.empty()) {
+    int count = 0;
+    for (multimap<int, Path>::iterator i = (this->routeMap).begin();
+         i != (this->routeMap).end();)
+    {
+      multimap<int, Path>::iterator erase_i = i;
+      i++;
+      for (unsigned int n = 0; n < batch.links.size(); n++) {
+        if ((erase_i->second).usesLink(batch.links[n].first, batch.links[n].second)) {
+          (this->routeMap).erase(erase_i);
+          count++;
+          break;
+        }
+      }
+    }
+
+    if (count > 0) {
+      this->forwardingStale = 1;
+      changes += count;
+      queue.noteLostRoutes(this);
+      for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
+           ri != (this->neighborRouters).end();
+           ri++)
+      {
+        for (unsigned int n = 0; n < batch.links.size(); n++) {
+          queue.withdrawLink(ri->second, batch.links[n].first, batch.links[n].second);
+        }
+      }
+    }
+  }
+
+  // Remove the routes to Hosts which are gone, passing the news on only if the
+  // Router had any.
+  for (unsigned int n = 0; n < batch.hosts.size(); n++) {
+    if ((this->routeMap).count(batch.hosts[n]) == 0) {
+      continue;
+    }
+    (this->routeMap).erase(batch.hosts[n]);
+    this->forwardingStale = 1;
+    changes++;
+    for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
+         ri != (this->neighborRouters).end();
+         ri++)
+    {
+      queue.withdrawHost(ri->second, batch.hosts[n]);
+    }
+  }
+
+  // Consider the routes offered. In BEST_PATHS mode the shortest are taken 
+  // first, so that routes replaced within the batch are never passed on. The
+  // routes of a batch usually arrive in order already.
+  if ((this->routingMode == BEST_PATHS) &&
+      !is_sorted((batch.routes).begin(), (batch.routes).end(), shorterRoute))
+  {
+    stable_sort((batch.routes).begin(), (batch.routes).end(), shorterRoute);
+  }
+  vector<int> added;
+  for (unsigned int n = 0; n < batch.routes.size(); n++) {
+    if (this->acceptRoute(batch.routes[n])) {
+      added.push_back(n);
+    }
+  }
+  changes += added.size();
+
+  // Pass on, with the Router in front, the routes added and still kept.
+  for (unsigned int n = 0; n < added.size(); n++) {
+    if ((this->routingMode == BEST_PATHS) && !(this->hasRoute(batch.routes[added[n]]))) {
+      continue;
+    }
+    Path v(this->getNumber(), batch.routes[added[n]]);
+    for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
+         ri != (this->neighborRouters).end();
+         ri++) 
+    {
+      queue.offerRoute(ri->second, v);
+    }
+  }
+  return changes;
+}
+
+/* --------------------------------------------------------------------------- */
+/* In BEST_PATHS mode, this function decides whether a new route to a Host is
+   among the shortest kept, removing the longest kept route if it is no longer
+   needed. Returns TRUE if the route should be added. */
+/* --------------------------------------------------------------------------- */
+bool Router::makeRoomForRoute(const Path &v) {
+  pair<multimap<int, Path>::iterator, 
+       multimap<int, Path>::iterator> range;
+  range = (this->routeMap).equal_range(v.destination());
+
+  // Find the longest route kept to the Host, and count the routes.
+  int count = 0;
+  multimap<int, Path>::iterator longest = range.first;
+  for (multimap<int, Path>::iterator i = range.first;
        i != range.second;
        i++) 
   {
-    if (i->second == v) return;
+    if ((i->second).size() > (longest->second).size()) {
+      longest = i;
+    }
+    count++;
   }
 
-  // Finally, we add the route to the Router's routeMap in the form:
-  // <Host id, route>, and recurse for all the Router's neighbors.
+  if (count < this->pathsKept) {
+    return 1;
+  }
 
-  (r->routeMap).insert(pair<int, vector<int> >(*(v.end()-1), v));
-  v.insert(v.begin(), r->getNumber());
+  // Of equally long routes, the one already kept stays, so that routes are not
+  // replaced back and forth.
+  if (v.size() < (longest->second).size()) {
+    (this->routeMap).erase(longest);
+    this->forwardingStale = 1;
+    return 1;
+  }
+  return 0;
+}
 
-  for(multimap<int, Router *>::iterator i = (r->neighborRouters).begin();
-      i != (r->neighborRouters).end();
-      i++) 
+/* --------------------------------------------------------------------------- */
+/* In BEST_PATHS mode a Router only knows the paths it kept, so when it loses
+   routes to a failed link it asks its neighbors to offer again their routes 
+   to the Hosts it now has too few routes to, letting it learn the next best.
+   Any it takes are passed on as usual. */
+/* --------------------------------------------------------------------------- */
+void Router::requestRoutes(UpdateQueue &queue) {
+  for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
+       ri != (this->neighborRouters).end();
+       ri++)
   {
-    updateNeighbor(i->second, v);
+    Router *neighbor = ri->second;
+    for (multimap<int, Path>::iterator i = (neighbor->routeMap).begin();
+         i != (neighbor->routeMap).end();
+         i++) 
+    {
+      if ((int) (this->routeMap).count(i->first) < this->pathsKept) {
+        queue.offerRoute(this, Path(neighbor->getNumber(), i->second));
+      }
+    }
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* In LINK_STATE mode, this function makes a new advertisement of the Router's
+   connections and floods it through the network. */
+/* --------------------------------------------------------------------------- */
+void Router::originateLinkState() {
+  LinkState *state = new LinkState;
+  state->router = this->getNumber();
+  state->sequence = ++(this->linkStateSequence);
+
+  // The keys of the neighbor tables come in order, as the database expects.
+  for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
+       ri != (this->neighborRouters).end();
+       ri++) 
+  {
+    (state->neighbors).push_back(ri->first);
+  }
+  for (multimap<int, Host *>::iterator hi = (this->neighborHosts).begin();
+       hi != (this->neighborHosts).end();
+       hi++) 
+  {
+    (state->hosts).push_back(hi->first);
+  }
+
+  shared_ptr<const LinkState> advert(state);
+  (this->linkStates).install(advert);
+  this->routesStale = 1;
+  this->forwardingStale = 1;
+
+  vector<shared_ptr<const LinkState> > states(1, advert);
+  for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
+       ri != (this->neighborRouters).end();
+       ri++) 
+  {
+    floodLinkStates(ri->second, this, states);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* This function gives advertisements to a Router, received from its neighbor
+   from. Each Router that finds an advertisement newer than its own copy keeps
+   it and passes it on to its other neighbors. */
+/* --------------------------------------------------------------------------- */
+void Router::floodLinkStates(Router *to, Router *from,
+                             const vector<shared_ptr<const LinkState> > &states) {
+  struct Update {
+    Router *to;
+    Router *from;
+    shared_ptr<const LinkState> state;
+  };
+
+  PropagationRound counts = {0, 0, 0, 0};
+  deque<Update> pending;
+  for (unsigned int n = 0; n < states.size(); n++) {
+    Update u = {to, from, states[n]};
+    pending.push_back(u);
   }
+
+  while (!pending.empty()) {
+    Update u = pending.front();
+    pending.pop_front();
+    counts.updates++;
+
+    // A Router which already has this advertisement, or a newer one, does not
+    // pass it on. This is what makes the flood terminate.
+    if (!((u.to)->linkStates).install(u.state)) {
+      continue;
+    }
+    (u.to)->routesStale = 1;
+    (u.to)->forwardingStale = 1;
+    counts.accepted++;
+
+    for (multimap<int, Router *>::iterator ri = ((u.to)->neighborRouters).begin();
+         ri != ((u.to)->neighborRouters).end();
+         ri++) 
+    {
+      if (ri->second != u.from) {
+        Update next = {ri->second, u.to, u.state};
+        pending.push_back(next);
+      }
+    }
+  }
+
+  // The flood counts as one round, in which each advertisement a Router took
+  // counts as a Router updated.
+  counts.routers = counts.accepted;
+  UpdateQueue::addRound(counts);
+}
+
+/* --------------------------------------------------------------------------- */
+/* In LINK_STATE mode, this function recomputes the Router's routeMap from its
+   link-state database if the database has changed since it was last computed.
+   Forwarding does not need the routeMap, so this is only done when the routes
+   themselves are asked for. */
+/* --------------------------------------------------------------------------- */
+void Router::refreshRoutes() {
+  if ((this->routingMode != LINK_STATE) || !(this->routesStale)) {
+    return;
+  }
+  (this->linkStates).shortestPaths(this->getNumber(), this->routeMap);
+  this->routesStale = 0;
 }
 
 /* --------------------------------------------------------------------------- */
@@ -154,8 +498,7 @@ void Router::updateNeighbor(Router *r, vector<int> v) {
    routers in its routeMap of the new connection.*/
 /* --------------------------------------------------------------------------- */
 void Router::connectTo(Host &h) {
-
-  if ((this->routeMap).count(h.getNumber()) > 0) {
+  if ((this->topology)->hasHost(h.getNumber())) {
     if (h.getConnection() != NULL) {
       cout << "Sorry, but you must disconnect from your current router and " 
            << "reconnect." << endl;
@@ -169,23 +512,31 @@ void Router::connectTo(Host &h) {
   
   // Update neighborHosts table.
   (this->neighborHosts).insert(pair<int, Host*>(h.getNumber(), &h));
+  (this->topology)->addHost(h.getNumber());
 
   // Add entry to the routeMap.
-  vector<int> route (1); 
-  *(route.begin()) = h.getNumber();
-  (this->routeMap).insert(pair<int, vector<int> >(h.getNumber(), route));
+  Path route(h.getNumber());
+  (this->routeMap).insert(pair<int, Path>(h.getNumber(), route));
+  this->forwardingStale = 1;
 
   // Have the Host update its connection.
   h.connectTo(this);
 
+  if (this->routingMode == LINK_STATE) {
+    this->originateLinkState();
+    return;
+  }
+
   // Update the Router's neighbors of the new connection.
-  route.insert(route.begin(), this->getNumber());
+  Path offer(this->getNumber(), route);
+  UpdateQueue queue;
   for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
        ri != (this->neighborRouters).end();
        ri++) 
   {
-    this->updateNeighbor(ri->second, route);
+    queue.offerRoute(ri->second, offer);
   }
+  queue.run();
 }
 
 /* --------------------------------------------------------------------------- */
@@ -203,17 +554,26 @@ void Router::disconnect(Host &h) {
 
   // Remove the connection from neighborHosts, routeMap, and the Host. 
   (this->neighborHosts).erase(h.getNumber());
+  (this->topology)->removeHost(h.getNumber());
   (this->routeMap).erase(h.getNumber());
+  this->forwardingStale = 1;
 
   h.disconnectFrom(this);
+
+  if (this->routingMode == LINK_STATE) {
+    this->originateLinkState();
+    return;
+  }
   
   // Update the Router's neighbors of the deletion of the connection.
+  UpdateQueue queue;
   for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
        ri != (this->neighborRouters).end();
        ri++) 
   {
-    this->updateNeighborDisconnectHost(ri->second, h);
+    queue.withdrawHost(ri->second, h.getNumber());
   }
+  queue.run();
 }
 
 /* --------------------------------------------------------------------------- */
@@ -221,19 +581,9 @@ void Router::disconnect(Host &h) {
    deletion from a neighbor, and update its neighbors about the deletion. */
 /* --------------------------------------------------------------------------- */
 void Router::updateNeighborDisconnectHost(Router *r, Host &h) {
-  // If the Host does not appear in its routeMap, end function call.
-  if ((r->routeMap).count(h.getNumber()) == 0) {
-    return;
-  }
-
-  (r->routeMap).erase(h.getNumber());
-  
-  for (multimap<int, Router *>::iterator ri = (r->neighborRouters).begin();
-       ri != (r->neighborRouters).end();
-       ri++) 
-  {
-    r->updateNeighborDisconnectHost(ri->second, h);
-  }
+  UpdateQueue queue;
+  queue.withdrawHost(r, h.getNumber());
+  queue.run();
 }
 
 /* --------------------------------------------------------------------------- */
@@ -254,51 +604,87 @@ void Router::disconnectFrom(Router &r) {
     cout << "Sorry, Router " << this->getNumber() << " and Router " 
          << other_router->getNumber() << " are not connected, and so cannot "
          << "disconnect from one another." << endl;
+    return;
   }
   
   // Remove the Routers from each others' neighborRouters tables.
   (this->neighborRouters).erase(other_router->getNumber());
   (other_router->neighborRouters).erase(this->getNumber());
+  Topology::split(this, other_router);
+
+  // In LINK_STATE mode, each Router advertises that the link is gone, and 
+  // every Router works out new routes from that.
+  if (this->routingMode == LINK_STATE) {
+    this->originateLinkState();
+    other_router->originateLinkState();
+    return;
+  }
 
   // Removes from this Router's routeMap all routes which include the other
   // Router as a first step.
-  for (multimap<int, vector<int> >::iterator i = (this->routeMap).begin();
+  for (multimap<int, Path>::iterator i = (this->routeMap).begin();
        i != (this->routeMap).end();)
   {
-    multimap<int, vector<int> >::iterator erase_i = i; // we must create another 
-                                                       // iterator because erase 
-                                                       // removes the multimap 
-                                                       // element AND invalidates 
-                                                       // the iterator
+    multimap<int, Path>::iterator erase_i = i; // we must create another 
+                                               // iterator because erase 
+                                               // removes the multimap 
+                                               // element AND invalidates 
+                                               // the iterator
     i++;
 
-    vector<int> v = erase_i->second;
-    if (v[0] == other_router->getNumber()) {
+    if ((erase_i->second).first() == other_router->getNumber()) {
       (this->routeMap).erase(erase_i);
+      this->forwardingStale = 1;
     }
   }
 
   // Removes from the other router's routeMap all routes which include this
   // Router as a first step.
-  for (multimap<int, vector<int> >::iterator i = (other_router->routeMap).begin();
+  for (multimap<int, Path>::iterator i = (other_router->routeMap).begin();
        i != (other_router->routeMap).end();)
   {
-    multimap<int, vector<int> >::iterator erase_i = i;
+    multimap<int, Path>::iterator erase_i = i;
     i++;
 
-    vector<int> v = erase_i->second;
-    if (v[0] == this->getNumber()) {
+    if ((erase_i->second).first() == this->getNumber()) {
       (other_router->routeMap).erase(erase_i);
+      other_router->forwardingStale = 1;
     }
   }
 
-  // Update each Router's neighbors of the deletion of the connection.
-  this->updateNeighborDisconnectRouter(this->getNumber(), 
-				       other_router->getNumber());
-
-  other_router->updateNeighborDisconnectRouter(this->getNumber(), 
-					       other_router->getNumber());
-
+  // Update each Router's neighbors of the deletion of the connection. A 
+  // neighbor which removes routes passes the deletion on (see 
+  // processUpdates()); one which removes none does not, so the process ends.
+  UpdateQueue queue;
+  for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
+       ri != (this->neighborRouters).end();
+       ri++)
+  {
+    queue.withdrawLink(ri->second, this->getNumber(), other_router->getNumber());
+  }
+  for (multimap<int, Router *>::iterator ri = (other_router->neighborRouters).begin();
+       ri != (other_router->neighborRouters).end();
+       ri++)
+  {
+    queue.withdrawLink(ri->second, this->getNumber(), other_router->getNumber());
+  }
+  queue.run();
+
+  // In BEST_PATHS mode, the Routers which lost routes, including these two,
+  // learn the next best from their neighbors. Routers which lost none still 
+  // have their best routes, so are left alone.
+  if (this->routingMode == BEST_PATHS) {
+    vector<Router *> lost = queue.takeLostRoutes();
+    lost.push_back(this);
+    lost.push_back(other_router);
+    set<Router *> asked;
+    for (unsigned int n = 0; n < lost.size(); n++) {
+      if (asked.insert(lost[n]).second) {
+        lost[n]->requestRoutes(queue);
+      }
+    }
+    queue.run();
+  }
 }
 
 /* --------------------------------------------------------------------------- */
@@ -312,50 +698,16 @@ void Router::disconnectFrom(Router &r) {
 void Router::updateNeighborDisconnectRouter(int num_router1, int num_router2) {
   // The process is carried out for each neighbor of the calling Router's 
   // neighbor table. The calling Router will already have been updated of the
-  // disconnection.
+  // disconnection. A neighbor which removes routes passes the deletion on (see
+  // processUpdates()); one which removes none does not, so the process ends.
+  UpdateQueue queue;
   for (multimap<int, Router *>::iterator ri = (this->neighborRouters).begin();
        ri != (this->neighborRouters).end();
        ri++)
   {
-    Router *r = ri->second;
-    int count = 0; // count tracks the number of deletions that occur. 
-
-    for (multimap<int, vector<int> >::iterator i = (r->routeMap).begin();
-         i != r->routeMap.end();)
-    {
-      multimap<int, vector<int> >::iterator erase_i = i;
-      i++;
-
-      // This loop deletes an entry from the routeMap if it contains the
-      // connection (router1, router2) or (router2, router1).
-      int prev_num = -999;
-      vector<int> v = erase_i->second;
-      for (vector<int>::iterator vi = v.begin();
-           vi != v.end() -1;
-           vi++)
-      {
-	if (((num_router1 == *vi) && (num_router2 == prev_num)) ||
-	    ((num_router2 == *vi) && (num_router1 == prev_num)))
-        {
-	  (r->routeMap).erase(erase_i);
-          count++;
-          break; // Once a connection instance is found and route deleted, 
-	         // should break from the loop. 
-	}
-	prev_num = *vi;
-      }
-    }
-    
-    // If no such connections were found in any entry of the routeMap, then 
-    // end the funciton call. This provides a base case for the recursion, so 
-    // the method terminates.
-    if (count == 0) {
-      return;
-    }
-
-    // Call the function on the current Router pointed to by r.
-    r->updateNeighborDisconnectRouter(num_router1, num_router2);
+    queue.withdrawLink(ri->second, num_router1, num_router2);
   }
+  queue.run();
 }
 
 /* --------------------------------------------------------------------------- */
@@ -364,145 +716,144 @@ void Router::updateNeighborDisconnectRouter(int num_router1, int num_router2) {
    destination Host, the router outputs an error message. If the Router is 
    connected to the destination Host directly, it forwards the message to the 
    Host. Otherwise, it finds the shortest route to the destination Host from its
-   routeMap and passes the Message to the next router in the route. */
+   routeMap and passes the Message to the next router in the route, and so on
+   until it arrives. */
 /* --------------------------------------------------------------------------- */
 void Router::receiveMessage(Message &message) {
-  // If there is no route to the destination Host, end the call.
-  if (routeMap.count(message.getDestination()) == 0) {
-    cout << "Routing of Message Failed at Router " << this->getNumber() << endl << endl;
-    return;
-  }
-
-  // If the Router is directly connected to the destination Host, forward the 
-  // Message to that Host.
-  if ((neighborHosts).count(message.getDestination())!=0) {
-    // The following line is complex, but is only used once in the program,
-    // therefore I did not put it in an abstraction function. The line finds the
-    // address of the destination Host in the Router's neighbor table and tells
-    // that Host to receive the Message.
-    ((neighborHosts.find(message.getDestination()))->second)->
-      receiveMessage(message);
-    return;
-  }
-
-  // From the possible routes in the routeMap which lead to the destination Host,
-  // select the route with the fewest steps.
-  pair<multimap<int,vector<int> >::iterator, 
-       multimap<int,vector<int> >::iterator> range;
-  range = routeMap.equal_range(message.getDestination());
-  
-  unsigned int min_length = ((range.first)->second).size();
-  multimap<int,vector<int> >::iterator min_i = range.first;
+  Router *here = this;
+  Router *next_router;
+  Host *next_host;
+
+  // The Message is passed along the route one Router at a time, rather than
+  // each Router calling the next, so a long route does not nest calls.
+  while (1) {
+    // If there is no route to the destination Host, end the call.
+    if (!(here->findNextHop(message.getDestination(), next_router, next_host))) {
+      cout << "Routing of Message Failed at Router " << here->getNumber() << endl << endl;
+      return;
+    }
 
-  for (multimap<int, vector<int> >::iterator i = range.first;
-       i != range.second;
-       i++)
-    {
-      if ((i->second).size() < min_length) {
-	min_length = (i->second).size();
-	min_i = i;
-      }
+    // If the Router is directly connected to the destination Host, forward the 
+    // Message to that Host. Otherwise forward it to the next neighboring Router
+    // on the shortest route.
+    if (next_host != NULL) {
+      next_host->receiveMessage(message);
+      return;
     }
-  
-  // Forward the message to the next neighboring Router in the route.
-  vector<int> route = min_i->second;
-  Router *next_hop = (neighborRouters.find(route[0]))->second;
-  next_hop -> receiveMessage(message);
+    here = next_router;
+  }
 }
 
-
 /* --------------------------------------------------------------------------- */
-/* Function to check if two Routers are connect within the same network, if so
-   then returns TRUE. Is used when checking if a connection is being attempted 
-   between two Routers in which the addresses of other Routers maybe the same. */
+/* Function to compile the forwarding table from the routeMap: for each Host, 
+   the Host itself if it is connected directly, otherwise the first Router on
+   the shortest route to it. In LINK_STATE mode the first Routers come 
+   straight from the link-state database instead. */
 /* --------------------------------------------------------------------------- */
-bool Router::isRouterInNetwork(int num, Router* r) {
-  // Uses bool asked == 1 as a base case, if a Router has already been asked, 
-  // then the current answer will not matter. Used to ensure termination, if the
-  // Router r does not appear in the same network.
-  if (this->getAsked() == 1) {
-    return 0;
-  }
+void Router::buildForwardingTable() {
+  // The table is compiled afresh rather than changed, since the old one may
+  // still be in use elsewhere.
+  shared_ptr<ForwardingTable> table = make_shared<ForwardingTable>();
 
-  this->setAsked(1);
+  if (this->routingMode == LINK_STATE) {
+    vector<pair<int, int> > hops;
+    (this->linkStates).firstHops(this->getNumber(), hops);
+    table->clear(hops.size());
 
-  // If we can find the Router address in the neighbor table, and the pointers
-  // match then they are in the same network.
-  if (((this->neighborRouters).count(num) > 0) && 
-      (((this->neighborRouters).find(num))->second == r)) 
-  {
-    return 1; 
+    // The nearest Hosts come first, so a Host advertised by more than one
+    // Router keeps its shortest route.
+    for (unsigned int n = 0; n < hops.size(); n++) {
+      int destination = hops[n].first;
+      if (table->find(destination) != NULL) {
+        continue;
+      }
+      multimap<int, Host *>::iterator hi = (this->neighborHosts).find(destination);
+      if (hi != (this->neighborHosts).end()) {
+        table->add(destination, NULL, hi->second);
+        continue;
+      }
+      multimap<int, Router *>::iterator ri = 
+        (this->neighborRouters).find(hops[n].second);
+      if (ri != (this->neighborRouters).end()) {
+        table->add(destination, ri->second, NULL);
+      }
+    }
+    this->forwarding = table;
+    this->forwardingStale = 0;
+    return;
   }
-  
-  // A router now asks its neighbors if they are connected to the Router r,
-  // as soon as one responds affirmitively, then they are in the same network. 
-  int answer = 0;
-  for (multimap<int, Router *>::iterator i =(this->neighborRouters).begin();
-       i != (this->neighborRouters).end();
-       i++)
-  {
-    answer = (answer + (i->second)->isRouterInNetwork(num, r));
-    if (answer >= 1) {
-      return 1;
 
+  table->clear((this->routeMap).size());
+
+  multimap<int, Path>::iterator i = (this->routeMap).begin();
+  while (i != (this->routeMap).end()) {
+    int destination = i->first;
+
+    // From the possible routes in the routeMap which lead to the destination
+    // Host, select the route with the fewest steps. Of equally short routes,
+    // the first is taken.
+    multimap<int, Path>::iterator min_i = i;
+    for (; (i != (this->routeMap).end()) && (i->first == destination); i++) {
+      if ((i->second).size() < (min_i->second).size()) {
+        min_i = i;
+      }
+    }
+
+    multimap<int, Host *>::iterator hi = (this->neighborHosts).find(destination);
+    if (hi != (this->neighborHosts).end()) {
+      table->add(destination, NULL, hi->second);
+      continue;
+    }
+    multimap<int, Router *>::iterator ri = 
+      (this->neighborRouters).find((min_i->second).first());
+    if (ri != (this->neighborRouters).end()) {
+      table->add(destination, ri->second, NULL);
     }
   }
-  return 0;
+  this->forwarding = table;
+  this->forwardingStale = 0;
 }
 
 /* --------------------------------------------------------------------------- */
-/* Function used to reset the asked attribute of all Routers in a network, must
-   be used after the isRouterInNetwork() function is called.*/
+/* Function to find where a Message for a destination Host goes next. Returns
+   FALSE if there is no route. */
 /* --------------------------------------------------------------------------- */
-void Router::resetAsked() {
-  if (this->getAsked() == 0) {
-    return;
+bool Router::findNextHop(int destination, Router *&router, Host *&host) {
+  if (this->forwardingStale) {
+    this->buildForwardingTable();
   }
-  this->setAsked(0);
-  for (multimap<int, Router *>::iterator i =(this->neighborRouters).begin();
-       i != (this->neighborRouters).end();
-       i++)
-  {
-    (i->second)->resetAsked();
+
+  const ForwardingTable::Entry *hop = (this->forwarding)->find(destination);
+  if (hop == NULL) {
+    router = NULL;
+    host = NULL;
+    return 0;
   }
+  router = hop->router;
+  host = hop->host;
+  return 1;
 }
 
 /* --------------------------------------------------------------------------- */
-/* Function to check if a certain router with addres num appears in a Router's
-   routeMap, if so returns TRUE. This function is used with isRouterInNetwork()
-   to distinguish cases in which two separate networks attempt to connect, but
-   they contain Routers with the same network addresses. */
+/* Function to return the Router's forwarding table as it is now, compiling it
+   first if the routeMap has changed. */
 /* --------------------------------------------------------------------------- */
-bool Router::isRouterInTable(int num) {
-  // First, read through the neighbor table for a match.
-  for (multimap<int, Router*>::iterator j = (this->neighborRouters).begin();
-       j != (this->neighborRouters).end();
-       j++)
-  {
-    if ((j->first) == num) {
-      return 1;
-    }
+shared_ptr<const ForwardingTable> Router::getForwardingSnapshot() {
+  if (this->forwardingStale) {
+    this->buildForwardingTable();
   }
+  return this->forwarding;
+}
 
-  // Now, read through the parts of the entries of the routeMap that 
-  // correspond with Router address numbers.
-  for (multimap<int, vector<int> >::iterator i = (this->routeMap).begin();
-       i != (this->routeMap).end();
-       i++)
-  {
-    for (vector<int>::iterator j = (i->second).begin();
-	 j != ((i->second).end()-1);
-	 j++)
-    {
-      if (*j == num) {
-	return 1;
-      }
-    }
-  }
-  
-  return 0;
+/* --------------------------------------------------------------------------- */
+/* Function to return the number of routes in the Router's routeMap. */
+/* --------------------------------------------------------------------------- */
+int Router::getRouteCount() {
+  this->refreshRoutes();
+  return (this->routeMap).size();
 }
 
+
 /* --------------------------------------------------------------------------- */
 /* Function to check if two separate networks are attempting to combine, but 
    they contain Router addresses that are the same, if so returns TRUE. If so, 
@@ -510,51 +861,16 @@ bool Router::isRouterInTable(int num) {
    networks. */
 /* --------------------------------------------------------------------------- */
 bool Router::checkIfNetworkCombineSameRouters(Router *other_router) {
-  // First, check whether the Routers are in the same network, if they are then
-  // no other check matters, best to get this out of the way first.
-  if (this->isRouterInNetwork(other_router->getNumber(), other_router)) {
-    this->resetAsked();    
-    return 0;
-  }
-  this->resetAsked();
-
-  // Second, check whether the other Router is the offending Router with the same
-  // address as a Router in THIS's network.
-  if ((this->isRouterInTable(other_router->getNumber())) && 
-      !(this->isRouterInNetwork(other_router->getNumber(), other_router)))
+  // Routers in the same network can always connect; otherwise look up the 
+  // Router addresses of one network in the other.
+  if ((this->topology == other_router->topology) ||
+      !((this->topology)->sharesRouterAddress(other_router->topology)))
   {
-    this->resetAsked();
-    cout << "Sorry, but you are attempting to combine separate networks in which" 
-	 << " a router address is currently in use in both networks." << endl;
-    return 1;
-  }
-  this->resetAsked();
-
-  // Finally, read through the other Router's network and see if a Router member 
-  // address is also found in the Router's network. If so, then the two networks
-  // have conflicting router names.
-  for (multimap<int, vector<int> >::iterator i =(other_router->routeMap).begin();
-       i != (other_router->routeMap).end();
-       i++)
-  {
-    for (vector<int>::iterator vi = (i->second).begin();
-	 vi != ((i->second).end()-1);
-	 vi++)
-    {
-      if ((this->isRouterInTable(*vi)))
-	{
-	  this->resetAsked();
-	  cout << "Sorry, but you are attempting to combine separate networks in" 
-	       << " which a router address is currently in use in both networks."
-	       << endl;
-	  return 1;
-	}
-      this->resetAsked();      
-    }
+    return 0;
   }
-
-  // Otherwise, the connection is fine in this regard.
-  return 0;
+  cout << "Sorry, but you are attempting to combine separate networks in which" 
+       << " a router address is currently in use in both networks." << endl;
+  return 1;
 }
 
 /* --------------------------------------------------------------------------- */
@@ -566,45 +882,30 @@ bool Router::checkIfNetworkCombineSameRouters(Router *other_router) {
 bool Router::checkIfNetworkCombineSameHosts(Router *other_router) {
   // Only need to worry about this type of address conflict if the routers are
   // not in the same network.
-  if (!(other_router->isRouterInNetwork(this->getNumber(), this))) {
-    other_router->resetAsked();
-    // Read through each Host in the routeMap, since this provides a full list
-    // of Host addresses in a Router's network.
-    for (multimap<int, vector<int> >::iterator i = (this->routeMap).begin();
-	 i != (this->routeMap).end();
-	 i++)
-    {
-      for (multimap<int, vector<int> >::iterator j = 
-	     (other_router->routeMap).begin();
-	   j != (other_router->routeMap).end();
-	   j++)
-      {
-	if (i->first == j->first) {
-	  cout << "Sorry, you are trying to combine separate networks, but "
-	       << "Hosts in each network share the same address." << endl;
-	  return 1;
-	}
-      }
-    }
+  if ((this->topology == other_router->topology) ||
+      !((this->topology)->sharesHostAddress(other_router->topology)))
+  {
+    return 0;
   }
-
-  //Otherwise, the connection is fine in this regard.
-  other_router->resetAsked();
-  return 0;
+  cout << "Sorry, you are trying to combine separate networks, but "
+       << "Hosts in each network share the same address." << endl;
+  return 1;
 } 
 
 /* --------------------------------------------------------------------------- */
 /* Prints the contents of a Router's routing table:[host_number, [route]]. */
 /* --------------------------------------------------------------------------- */
 void Router::printRoutingTable() {
-    for (multimap<int, vector<int> >::iterator i = (this->routeMap).begin();
+    this->refreshRoutes();
+    for (multimap<int, Path>::iterator i = (this->routeMap).begin();
          i != (this->routeMap).end();
          i++)  {
             cout << "[" << i->first << ", [" ;
-            for (vector<int>::iterator j = (i->second).begin();
-                 j != (i->second).end();
+            vector<int> route = (i->second).entries();
+            for (vector<int>::iterator j = route.begin();
+                 j != route.end();
                  j++) {
-                    if (j != (i->second).begin()) {
+                    if (j != route.begin()) {
                         cout << ", ";
                     }
                     cout << *j;
@@ -10,28 +10,47 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+
+#include "linkstate.h"
+#include "forwarding.h"
+#include "propagation.h"
+#include "path.h"
+#include "topology.h"
 
 using namespace std;
 
 class Host;
 class Message;
 
+// How Routers keep routes. ALL_PATHS keeps every loop-free path to every Host
+// and passes them all on; BEST_PATHS keeps only the shortest few paths to each
+// Host and passes a path on only when it is one of them, in the manner of a
+// distance-vector protocol. In LINK_STATE mode Routers pass on descriptions of
+// their connections instead, and each works out its own shortest routes.
+enum RoutingMode { ALL_PATHS, BEST_PATHS, LINK_STATE };
+
 class Router {
 private:
+  RoutingMode routingMode;              // Fixed when the Router is made, since
+  int pathsKept;                        // a Router keeps state of its mode.
+                                        // pathsKept is the number of paths to
+                                        // each Host kept in BEST_PATHS mode.
+
   int number;                           // int represents the address of Router.
 
-  bool asked;                           // bool used to terminate certain
-                                        // functions, specifically 
-                                        // isRouterInNetwork().
+  Topology *topology;                   // The Routers and Hosts of the 
+                                        // network the Router is in, shared by
+                                        // all of them.
 
-  multimap<int, vector<int> > routeMap; // Keeps track of all possible routes to
+  multimap<int, Path> routeMap;         // Keeps track of all possible routes to
                                         // all possible Hosts connected to the
                                         // Router directly, or indirectly via 
                                         // connected Routers. The key int is the 
                                         // address of a Host. The route is a 
-                                        // vector of integers whose last entry is
-                                        // the Host address, and the preceding
-                                        // the Routers needed to pass through.
+                                        // Path whose last entry is the Host 
+                                        // address, and the preceding the 
+                                        // Routers needed to pass through.
 
   multimap<int, Router *> neighborRouters; // Keeps track of all Routers a Router
                                            // is connected to. The Key is the int
@@ -44,11 +63,38 @@ private:
                                       // int address of a Host, which is 
                                       // associated with the Host's memory 
                                       // address.
+
+  LinkStateDatabase linkStates;       // In LINK_STATE mode, the newest 
+                                      // advertisement of every Router the 
+                                      // Router has heard from.
+
+  unsigned int linkStateSequence;     // Number of the Router's own newest
+                                      // advertisement.
+
+  bool routesStale;                   // In LINK_STATE mode, TRUE when 
+                                      // linkStates has changed since routeMap
+                                      // was last computed from it.
+
+  shared_ptr<const ForwardingTable> forwarding;
+                                      // The next hop to each Host in routeMap,
+                                      // compiled from routeMap so that 
+                                      // forwarding a Message is one lookup.
+                                      // A compiled table is never changed, 
+                                      // only replaced, so it can be read by 
+                                      // other threads while the Router changes.
+
+  bool forwardingStale;               // TRUE when routeMap, or in LINK_STATE
+                                      // mode linkStates, has changed since
+                                      // forwarding was last compiled from it.
 public:
 /* --------------------------------------------------------------------------- */
-/* Constructor function for Router. */
+/* Constructor function for Router, choosing how it keeps routes: every 
+   loop-free path (ALL_PATHS, the default), the shortest paths to each Host 
+   (BEST_PATHS, keeping up to paths of them), or routes worked out from 
+   link-state advertisements (LINK_STATE). Only Routers of the same mode can
+   be connected. */
 /* --------------------------------------------------------------------------- */
-  Router(int n);
+  Router(int n, RoutingMode mode = ALL_PATHS, int paths = 1);
 
 /* --------------------------------------------------------------------------- */
 /* Function to return the int number of the Router. */
@@ -56,14 +102,31 @@ public:
   int getNumber();
 
 /* --------------------------------------------------------------------------- */
-/* Function to return the bool asked of the Router. */
+/* Destructor function for Router, removing it from its network's Topology. */
+/* --------------------------------------------------------------------------- */
+  ~Router();
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the Topology of the Router's network. */
+/* --------------------------------------------------------------------------- */
+  Topology *getTopology();
+
+/* --------------------------------------------------------------------------- */
+/* Function to reset the Topology of the Router's network, when its network
+   is merged with another or split. */
+/* --------------------------------------------------------------------------- */
+  void setTopology(Topology *t);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the Router's neighboring Routers and Hosts tables. */
 /* --------------------------------------------------------------------------- */
-  bool getAsked();
+  const multimap<int, Router *> &getNeighborRouters();
+  const multimap<int, Host *> &getNeighborHosts();
 
 /* --------------------------------------------------------------------------- */
-/* Function to reset the bool asked of the Router. */
+/* Function to return the Router's routing mode. */
 /* --------------------------------------------------------------------------- */
-  void setAsked(bool a);
+  RoutingMode getRoutingMode();
   
 /* --------------------------------------------------------------------------- */
 /* Function to Connect two Routers together by swapping their route tables:
@@ -78,11 +141,75 @@ public:
 /* --------------------------------------------------------------------------- */
   void transmitRoutes();
 
+/* --------------------------------------------------------------------------- */
+/* This function adds to a queue the offer of every route in the Router's 
+   routeMap, with the Router in front, to each of its neighbor Routers. */
+/* --------------------------------------------------------------------------- */
+  void offerRoutes(UpdateQueue &queue);
+
 /* --------------------------------------------------------------------------- */
 /* This function sends a route to a Router, which then checks the route before 
    adding the route to its routeMap. */
 /* --------------------------------------------------------------------------- */
-  void updateNeighbor(Router *r, vector<int> v);
+  void updateNeighbor(Router *r, const Path &v);
+
+/* --------------------------------------------------------------------------- */
+/* Function to check whether a route is already in the Router's routeMap. */
+/* --------------------------------------------------------------------------- */
+  bool hasRoute(const Path &v);
+
+/* --------------------------------------------------------------------------- */
+/* This function checks a route offered by a neighbor and adds it to the 
+   Router's routeMap if it should be kept. Returns TRUE if it was added. */
+/* --------------------------------------------------------------------------- */
+  bool acceptRoute(const Path &v);
+
+/* --------------------------------------------------------------------------- */
+/* This function deals with a batch of updates from an UpdateQueue: links which 
+   are gone, Hosts which are gone, and routes offered. Updates which change the
+   Router's routeMap are passed on to its neighbors through the queue. Returns
+   the number of updates which changed the routeMap. */
+/* --------------------------------------------------------------------------- */
+  int processUpdates(UpdateQueue::Batch &batch, UpdateQueue &queue);
+
+/* --------------------------------------------------------------------------- */
+/* In BEST_PATHS mode, this function decides whether a new route to a Host is
+   among the shortest kept, removing the longest kept route if it is no longer
+   needed. Returns TRUE if the route should be added. */
+/* --------------------------------------------------------------------------- */
+  bool makeRoomForRoute(const Path &v);
+
+/* --------------------------------------------------------------------------- */
+/* In BEST_PATHS mode a Router only knows the paths it kept, so when it loses
+   routes to a failed link it asks its neighbors to offer again their routes 
+   to the Hosts it now has too few routes to, letting it learn the next best. */
+/* --------------------------------------------------------------------------- */
+  void requestRoutes(UpdateQueue &queue);
+
+/* --------------------------------------------------------------------------- */
+/* In LINK_STATE mode, this function makes a new advertisement of the Router's
+   connections and floods it through the network. */
+/* --------------------------------------------------------------------------- */
+  void originateLinkState();
+
+/* --------------------------------------------------------------------------- */
+/* This function gives advertisements to a Router, received from its neighbor
+   from. Each Router that finds an advertisement newer than its own copy keeps
+   it and passes it on to its other neighbors. The flood is worked through
+   with a queue rather than recursion, so it does not grow the stack however 
+   large the network. */
+/* --------------------------------------------------------------------------- */
+  static void floodLinkStates(Router *to, Router *from,
+                              const vector<shared_ptr<const LinkState> > &states);
+
+/* --------------------------------------------------------------------------- */
+/* In LINK_STATE mode, this function recomputes the Router's routeMap from its
+   link-state database if the database has changed since it was last computed.
+   Routes are only computed when they are needed, so a burst of advertisements 
+   costs one computation; forwarding takes its first hops straight from the
+   database, so only printing or counting the routes needs them. */
+/* --------------------------------------------------------------------------- */
+  void refreshRoutes();
 
 /* --------------------------------------------------------------------------- */
 /* This function connects a Router to a Host: the function first checks for 
@@ -122,35 +249,43 @@ public:
   void updateNeighborDisconnectRouter(int num_router1, int num_router2);
 
 /* --------------------------------------------------------------------------- */
-/* This function dictates the actions of a Router when it receives a Message 
-   either from a Host or from another Router. If there is no connection to the 
-   destination Host, the router outputs an error message. If the Router is 
-   connected to the destination Host directly, it forwards the message to the 
-   Host. Otherwise, it finds the shortest route to the destination Host from its
-   routeMap and passes the Message to the next router in the route. */
+/* Function to compile the forwarding table from the routeMap: for each Host, 
+   the Host itself if it is connected directly, otherwise the first Router on
+   the shortest route to it. In LINK_STATE mode the first Routers come 
+   straight from the link-state database instead. */
 /* --------------------------------------------------------------------------- */
-  void receiveMessage(Message &message);
+  void buildForwardingTable();
+
+/* --------------------------------------------------------------------------- */
+/* Function to find where a Message for a destination Host goes next: sets 
+   router to the next Router, or host to the Host itself if it is connected
+   directly (the other is set to NULL). Returns FALSE if there is no route. */
+/* --------------------------------------------------------------------------- */
+  bool findNextHop(int destination, Router *&router, Host *&host);
 
 /* --------------------------------------------------------------------------- */
-/* Function to check if two Routers are connect within the same network, if so
-   then returns TRUE. Is used when checking if a connection is being attempted 
-   between two Routers in which the addresses of other Routers maybe the same. */
+/* Function to return the Router's forwarding table as it is now, compiling it
+   first if the routeMap has changed. The table returned is never changed, so
+   it stays as it is, and can be read from any thread, while the Router goes on
+   being connected and disconnected. */
 /* --------------------------------------------------------------------------- */
-  bool isRouterInNetwork(int num, Router* R);
+  shared_ptr<const ForwardingTable> getForwardingSnapshot();
 
 /* --------------------------------------------------------------------------- */
-/* Function used to reset the asked attribute of all Routers in a network, must
-   be used after the isRouterInNetwork() function is called.*/
+/* Function to return the number of routes in the Router's routeMap. */
 /* --------------------------------------------------------------------------- */
-  void resetAsked();
+  int getRouteCount();
 
 /* --------------------------------------------------------------------------- */
-/* Function to check if a certain router with addres num appears in a Router's
-   routeMap, if so returns TRUE. This function is used with isRouterInNetwork()
-   to distinguish cases in which two separate networks attempt to connect, but
-   they contain Routers with the same network addresses. */
+/* This function dictates the actions of a Router when it receives a Message 
+   either from a Host or from another Router. If there is no connection to the 
+   destination Host, the router outputs an error message. If the Router is 
+   connected to the destination Host directly, it forwards the message to the 
+   Host. Otherwise, it finds the shortest route to the destination Host from its
+   routeMap and passes the Message to the next router in the route, and so on
+   until it arrives. */
 /* --------------------------------------------------------------------------- */
-  bool isRouterInTable(int num);
+  void receiveMessage(Message &message);
 
 /* --------------------------------------------------------------------------- */
 /* Function to check if two separate networks are attempting to combine, but 
@@ -0,0 +1,413 @@
+#include <iostream>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "runtime.h"
+#include "router.h"
+#include "host.h"
+#include "message.h"
+
+using namespace std;
+
+// Most Letters an actor deals with in one turn, before letting other actors
+// queued with the same worker have theirs.
+static const int TURN_LENGTH = 64;
+
+// Times a worker looks for an actor to run, yielding in between, before it
+// waits to be woken.
+static const int IDLE_SPINS = 64;
+
+// The Runtime and worker the running thread belongs to, if it is a worker.
+static thread_local Runtime *currentRuntime = NULL;
+static thread_local unsigned int currentWorker = 0;
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for a Runtime with the given number of worker
+   threads, or one per core if 0. */
+/* --------------------------------------------------------------------------- */
+Runtime::Runtime(unsigned int threads)
+  : threads(threads), started(0), verbose(0), sent(0), unroutable(0),
+    inFlight(0), readyCount(0), sleeping(0), stopping(0)
+{
+  if (this->threads == 0) {
+    this->threads = thread::hardware_concurrency();
+  }
+  if (this->threads == 0) {
+    this->threads = 1;
+  }
+  for (unsigned int w = 0; w < this->threads; w++) {
+    Worker *worker = new Worker();
+    (worker->delivered).store(0);
+    (worker->unroutable).store(0);
+    (worker->hops).store(0);
+    (worker->steals).store(0);
+    (this->workers).push_back(worker);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Destructor function for a Runtime, stopping it, deleting any Messages not
+   yet delivered and detaching its Hosts. */
+/* --------------------------------------------------------------------------- */
+Runtime::~Runtime() {
+  this->stop();
+  for (unsigned int n = 0; n < (this->actors).size(); n++) {
+    Actor *a = (this->actors)[n];
+    Letter *letter;
+    while ((letter = (a->mailbox).take()) != NULL) {
+      delete letter;
+    }
+    if (a->host != NULL) {
+      (a->host)->setRuntime(NULL);
+    }
+    delete a;
+  }
+  for (unsigned int w = 0; w < (this->workers).size(); w++) {
+    delete (this->workers)[w];
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to add an actor for a Router or Host, if it has none. */
+/* --------------------------------------------------------------------------- */
+void Runtime::addActor(Router *r, Host *h) {
+  const void *key = (r != NULL) ? (const void *) r : (const void *) h;
+  if ((this->actorFor).count(key) > 0) {
+    return;
+  }
+  Actor *a = new Actor();
+  (a->queued).store(0);
+  a->number = (r != NULL) ? r->getNumber() : h->getNumber();
+  a->router = r;
+  a->host = h;
+  a->home = (this->actors).size() % this->threads;
+  (this->actors).push_back(a);
+  (this->actorFor)[key] = a;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to add every Router in a Router's network, and every Host
+   connected to them, to the Runtime, and attach the Hosts to it. */
+/* --------------------------------------------------------------------------- */
+void Runtime::attach(Router &r) {
+  if (this->started) {
+    cout << "Sorry, Routers cannot be added to a Runtime while it is running." << endl;
+    return;
+  }
+  if ((this->actorFor).count(&r) > 0) {
+    // The Router's network has already been added.
+    return;
+  }
+
+  vector<Router *> found;
+  found.push_back(&r);
+  this->addActor(&r, NULL);
+  for (unsigned int n = 0; n < found.size(); n++) {
+    const multimap<int, Router *> &neighbors = found[n]->getNeighborRouters();
+    for (multimap<int, Router *>::const_iterator ri = neighbors.begin();
+         ri != neighbors.end();
+         ri++)
+    {
+      if ((this->actorFor).count(ri->second) == 0) {
+        this->addActor(ri->second, NULL);
+        found.push_back(ri->second);
+      }
+    }
+
+    const multimap<int, Host *> &connected = found[n]->getNeighborHosts();
+    for (multimap<int, Host *>::const_iterator hi = connected.begin();
+         hi != connected.end();
+         hi++)
+    {
+      this->addActor(NULL, hi->second);
+      (hi->second)->setRuntime(this);
+    }
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to set whether Hosts print the Messages they receive. */
+/* --------------------------------------------------------------------------- */
+void Runtime::setVerbose(bool v) {
+  this->verbose = v;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to start the worker threads, taking a snapshot of every Router's
+   forwarding table. */
+/* --------------------------------------------------------------------------- */
+void Runtime::start() {
+  if (this->started) {
+    return;
+  }
+  for (unsigned int n = 0; n < (this->actors).size(); n++) {
+    Actor *a = (this->actors)[n];
+    if (a->router != NULL) {
+      a->table = (a->router)->getForwardingSnapshot();
+    }
+  }
+
+  this->started = 1;
+  (this->stopping).store(0);
+  for (unsigned int w = 0; w < this->threads; w++) {
+    (this->workers)[w]->running = thread(&Runtime::work, this, w);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to stop the worker threads, once they have dealt with the
+   Messages in flight. */
+/* --------------------------------------------------------------------------- */
+void Runtime::stop() {
+  if (!(this->started)) {
+    return;
+  }
+  this->wait();
+  {
+    lock_guard<mutex> guard(this->idleLock);
+    (this->stopping).store(1);
+    (this->idle).notify_all();
+  }
+  for (unsigned int w = 0; w < this->threads; w++) {
+    ((this->workers)[w]->running).join();
+  }
+  this->started = 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to take new snapshots of the Routers' forwarding tables. Workers
+   pick up the new snapshot of a Router at its next turn. */
+/* --------------------------------------------------------------------------- */
+void Runtime::refresh() {
+  for (unsigned int n = 0; n < (this->actors).size(); n++) {
+    Actor *a = (this->actors)[n];
+    if (a->router != NULL) {
+      atomic_store(&(a->table), (a->router)->getForwardingSnapshot());
+    }
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function for a Host to send a Message: it is put in the mailbox of the
+   Host's Router. */
+/* --------------------------------------------------------------------------- */
+void Runtime::send(Host &from, int destination, const Payload &payload) {
+  (this->sent)++;
+  Router *r = from.getConnection();
+  unordered_map<const void *, Actor *>::iterator found = (this->actorFor).end();
+  if (r != NULL) {
+    found = (this->actorFor).find(r);
+  }
+  if (found == (this->actorFor).end()) {
+    (this->unroutable)++;
+    return;
+  }
+
+  Letter *letter = new Letter(from.getNumber(), destination, payload);
+  (this->inFlight)++;
+  this->deliver(found->second, letter);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to put a Letter in an actor's mailbox, queueing the actor if it is
+   not already queued. */
+/* --------------------------------------------------------------------------- */
+void Runtime::deliver(Actor *a, Letter *letter) {
+  (a->mailbox).put(letter);
+  if (!(a->queued).exchange(1)) {
+    this->schedule(a);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to queue an actor which has mail: with the worker doing the
+   queueing, so that a Message tends to stay on one core along its route, or
+   with the actor's own worker if not called by a worker. */
+/* --------------------------------------------------------------------------- */
+void Runtime::schedule(Actor *a) {
+  unsigned int w = (currentRuntime == this) ? currentWorker : a->home;
+  Worker *worker = (this->workers)[w];
+
+  // Counted before the actor is queued, so that it is never found before it
+  // is counted.
+  (this->readyCount)++;
+  {
+    lock_guard<mutex> guard(worker->lock);
+    (worker->ready).push_back(a);
+  }
+  if ((this->sleeping).load() > 0) {
+    lock_guard<mutex> guard(this->idleLock);
+    (this->idle).notify_one();
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to find an actor for a worker to run: its own newest, or another
+   worker's oldest. Returns NULL if every queue is empty. */
+/* --------------------------------------------------------------------------- */
+Runtime::Actor *Runtime::findWork(unsigned int w) {
+  Worker *own = (this->workers)[w];
+  {
+    lock_guard<mutex> guard(own->lock);
+    if (!(own->ready).empty()) {
+      Actor *a = (own->ready).back();
+      (own->ready).pop_back();
+      return a;
+    }
+  }
+
+  for (unsigned int n = 1; n < this->threads; n++) {
+    Worker *other = (this->workers)[(w + n) % this->threads];
+    lock_guard<mutex> guard(other->lock);
+    if (!(other->ready).empty()) {
+      Actor *a = (other->ready).front();
+      (other->ready).pop_front();
+      (own->steals).fetch_add(1, memory_order_relaxed);
+      return a;
+    }
+  }
+  return NULL;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function for a worker to deal with some of an actor's mail: a Router passes
+   each Message to the next actor on its way, and a Host receives it. */
+/* --------------------------------------------------------------------------- */
+void Runtime::runActor(Worker &worker, Actor *a) {
+  shared_ptr<const ForwardingTable> table;
+  if (a->router != NULL) {
+    table = atomic_load(&(a->table));
+  }
+
+  for (int n = 0; n < TURN_LENGTH; n++) {
+    Letter *letter = (a->mailbox).take();
+    if (letter == NULL) {
+      break;
+    }
+
+    if (a->host != NULL) {
+      (worker.delivered).fetch_add(1, memory_order_relaxed);
+      if (this->verbose) {
+        lock_guard<mutex> guard(this->printLock);
+        (a->host)->receiveMessage(letter->message);
+      }
+      this->finish(letter);
+      continue;
+    }
+
+    const ForwardingTable::Entry *hop = table->find((letter->message).getDestination());
+    unordered_map<const void *, Actor *>::iterator next = (this->actorFor).end();
+    if (hop != NULL) {
+      if (hop->router != NULL) {
+        next = (this->actorFor).find(hop->router);
+      } else {
+        next = (this->actorFor).find(hop->host);
+      }
+    }
+    if (next == (this->actorFor).end()) {
+      (worker.unroutable).fetch_add(1, memory_order_relaxed);
+      if (this->verbose) {
+        lock_guard<mutex> guard(this->printLock);
+        cout << "Routing of Message Failed at Router " << a->number << endl << endl;
+      }
+      this->finish(letter);
+      continue;
+    }
+    (worker.hops).fetch_add(1, memory_order_relaxed);
+    this->deliver(next->second, letter);
+  }
+
+  // If there is mail left, the actor stays queued and has another turn later.
+  // Otherwise it stops being queued, unless mail arrived after it was found
+  // empty, in which case the sender may have found it still queued.
+  if ((a->mailbox).hasMail()) {
+    this->schedule(a);
+    return;
+  }
+  (a->queued).store(0);
+  if ((a->mailbox).hasNewMail() && !(a->queued).exchange(1)) {
+    this->schedule(a);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to count a Message as delivered or dropped, and delete it. */
+/* --------------------------------------------------------------------------- */
+void Runtime::finish(Letter *letter) {
+  delete letter;
+  if (--(this->inFlight) == 0) {
+    lock_guard<mutex> guard(this->idleLock);
+    (this->done).notify_all();
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function run by each worker thread until the Runtime stops: it runs actors
+   while there are any, and otherwise waits for one to be queued. */
+/* --------------------------------------------------------------------------- */
+void Runtime::work(unsigned int w) {
+  currentRuntime = this;
+  currentWorker = w;
+  Worker &worker = *((this->workers)[w]);
+
+  int spins = 0;
+  while (1) {
+    Actor *a = this->findWork(w);
+    if (a != NULL) {
+      (this->readyCount)--;
+      this->runActor(worker, a);
+      spins = 0;
+      continue;
+    }
+    if ((this->stopping).load()) {
+      break;
+    }
+    if (spins < IDLE_SPINS) {
+      spins++;
+      this_thread::yield();
+      continue;
+    }
+
+    unique_lock<mutex> guard(this->idleLock);
+    (this->sleeping)++;
+    while (((this->readyCount).load() <= 0) && !(this->stopping).load()) {
+      (this->idle).wait(guard);
+    }
+    (this->sleeping)--;
+    spins = 0;
+  }
+  currentRuntime = NULL;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to wait until every Message sent so far has been delivered or
+   dropped. Returns at once if the Runtime has not been started. */
+/* --------------------------------------------------------------------------- */
+void Runtime::wait() {
+  if (!(this->started)) {
+    return;
+  }
+  unique_lock<mutex> guard(this->idleLock);
+  while ((this->inFlight).load() > 0) {
+    (this->done).wait(guard);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the counts so far, adding up those of the workers. */
+/* --------------------------------------------------------------------------- */
+RuntimeStats Runtime::getStats() {
+  RuntimeStats total = {(this->sent).load(), 0, (this->unroutable).load(), 0, 0};
+  for (unsigned int w = 0; w < (this->workers).size(); w++) {
+    Worker *worker = (this->workers)[w];
+    total.delivered += (worker->delivered).load();
+    total.unroutable += (worker->unroutable).load();
+    total.hops += (worker->hops).load();
+    total.steals += (worker->steals).load();
+  }
+  return total;
+}
@@ -0,0 +1,197 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+#include <vector>
+#include <deque>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <unordered_map>
+
+#include "mailbox.h"
+#include "message.h"
+
+using namespace std;
+
+class Router;
+class Host;
+class ForwardingTable;
+
+/* --------------------------------------------------------------------------- */
+/* Counts for everything a Runtime has done since it was made. */
+/* --------------------------------------------------------------------------- */
+struct RuntimeStats {
+  long sent;         // Messages sent by Hosts.
+  long delivered;    // Messages which reached their destination Host.
+  long unroutable;   // Messages dropped because a Router had no route, or the
+                     // sending Host was not connected.
+  long hops;         // times a Router passed a Message on.
+  long steals;       // times a worker took an actor from another worker.
+};
+
+/* --------------------------------------------------------------------------- */
+/* Runs the Routers and Hosts of one or more networks on a pool of worker
+   threads, so that Messages are forwarded on all cores at once. Every Router
+   and Host is an actor with a mailbox: forwarding a Message means putting it
+   in the mailbox of the next Router or Host, and an actor with mail waits in
+   a worker's queue for its turn, when it deals with its mail in order. Each
+   actor belongs to one worker, but a worker with nothing to do takes actors
+   from the others. Routers forward by a snapshot of their forwarding table
+   taken at start() or refresh(), so the network itself can go on changing
+   (but its Routers and Hosts not be deleted) while the Runtime runs. */
+/* --------------------------------------------------------------------------- */
+class Runtime {
+private:
+  struct Letter {
+    atomic<Letter *> next;   // for the Mailbox.
+    Message message;
+
+    Letter() : message(-1, -1, Payload()) {}
+    Letter(int s, int d, const Payload &p) : message(s, d, p) {}
+  };
+
+  struct Actor {
+    Mailbox<Letter> mailbox;
+    atomic<bool> queued;     // TRUE while the actor is in a worker's queue or
+                             // being run, so that it is only run by one worker
+                             // at a time.
+    int number;              // address of the Router or Host.
+    Router *router;          // the Router or Host the actor stands for.
+    Host *host;
+    shared_ptr<const ForwardingTable> table;  // for a Router.
+    unsigned int home;       // worker the actor belongs to.
+  };
+
+  struct Worker {
+    mutex lock;              // guards ready.
+    deque<Actor *> ready;    // actors with mail. The worker takes the newest,
+                             // others take the oldest.
+    thread running;
+
+    atomic<long> delivered;  // counts for the Messages this worker dealt with,
+    atomic<long> unroutable; // as in RuntimeStats.
+    atomic<long> hops;
+    atomic<long> steals;
+  };
+
+  vector<Actor *> actors;
+  unordered_map<const void *, Actor *> actorFor;  // Router or Host -> actor.
+
+  vector<Worker *> workers;
+  unsigned int threads;
+  bool started;
+  bool verbose;              // TRUE to have Hosts print Messages they receive.
+
+  atomic<long> sent;
+  atomic<long> unroutable;   // counted when a Host with no Router sends.
+  atomic<long> inFlight;     // Messages sent and not yet delivered or dropped.
+  atomic<long> readyCount;   // actors in the workers' queues.
+  atomic<int> sleeping;      // workers waiting for actors to be queued.
+  atomic<bool> stopping;
+
+  mutex idleLock;            // for workers to wait for actors to be queued,
+  condition_variable idle;   // and for wait() to wait for Messages to be
+  condition_variable done;   // delivered.
+
+  mutex printLock;           // so that printing by Hosts is not interleaved.
+
+/* --------------------------------------------------------------------------- */
+/* Function to add an actor for a Router or Host, if it has none. */
+/* --------------------------------------------------------------------------- */
+  void addActor(Router *r, Host *h);
+
+/* --------------------------------------------------------------------------- */
+/* Function to put a Letter in an actor's mailbox, queueing the actor if it is
+   not already queued. */
+/* --------------------------------------------------------------------------- */
+  void deliver(Actor *a, Letter *letter);
+
+/* --------------------------------------------------------------------------- */
+/* Function to queue an actor which has mail: with the worker doing the
+   queueing, or with the actor's own worker if not called by a worker. */
+/* --------------------------------------------------------------------------- */
+  void schedule(Actor *a);
+
+/* --------------------------------------------------------------------------- */
+/* Function to find an actor for a worker to run: its own newest, or another
+   worker's oldest. Returns NULL if every queue is empty. */
+/* --------------------------------------------------------------------------- */
+  Actor *findWork(unsigned int w);
+
+/* --------------------------------------------------------------------------- */
+/* Function for a worker to deal with some of an actor's mail. */
+/* --------------------------------------------------------------------------- */
+  void runActor(Worker &worker, Actor *a);
+
+/* --------------------------------------------------------------------------- */
+/* Function to count a Message as delivered or dropped, and delete it. */
+/* --------------------------------------------------------------------------- */
+  void finish(Letter *letter);
+
+/* --------------------------------------------------------------------------- */
+/* Function run by each worker thread until the Runtime stops. */
+/* --------------------------------------------------------------------------- */
+  void work(unsigned int w);
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for a Runtime with the given number of worker
+   threads, or one per core if 0. */
+/* --------------------------------------------------------------------------- */
+  Runtime(unsigned int threads = 0);
+
+/* --------------------------------------------------------------------------- */
+/* Destructor function for a Runtime, stopping it and deleting any Messages
+   not yet delivered. */
+/* --------------------------------------------------------------------------- */
+  ~Runtime();
+
+/* --------------------------------------------------------------------------- */
+/* Function to add every Router in a Router's network, and every Host
+   connected to them, to the Runtime, and attach the Hosts to it so that
+   Messages they send are forwarded by the Runtime. Routers and Hosts cannot
+   be added while the Runtime is running. */
+/* --------------------------------------------------------------------------- */
+  void attach(Router &r);
+
+/* --------------------------------------------------------------------------- */
+/* Function to set whether Hosts print the Messages they receive. */
+/* --------------------------------------------------------------------------- */
+  void setVerbose(bool v);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to start the worker threads, taking a snapshot of every Router's
+   forwarding table, and to stop them once they have dealt with the Messages
+   in flight. */
+/* --------------------------------------------------------------------------- */
+  void start();
+  void stop();
+
+/* --------------------------------------------------------------------------- */
+/* Function to take new snapshots of the Routers' forwarding tables, after
+   changes to the network. Can be called while the Runtime is running, from
+   the thread which changes the network. */
+/* --------------------------------------------------------------------------- */
+  void refresh();
+
+/* --------------------------------------------------------------------------- */
+/* Function for a Host to send a Message, as Host::send() does for a Host
+   attached to the Runtime. Can be called from any thread, and before start(),
+   in which case the Message waits until the Runtime starts. */
+/* --------------------------------------------------------------------------- */
+  void send(Host &from, int destination, const Payload &payload);
+
+/* --------------------------------------------------------------------------- */
+/* Function to wait until every Message sent so far has been delivered or
+   dropped. */
+/* --------------------------------------------------------------------------- */
+  void wait();
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the counts so far. */
+/* --------------------------------------------------------------------------- */
+  RuntimeStats getStats();
+};
+
+#endif
@@ -0,0 +1,278 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+
+#include "simulator.h"
+#include "router.h"
+#include "host.h"
+#include "message.h"
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for a Simulator whose links all have the given latency
+   and bandwidth, unless set otherwise. */
+/* --------------------------------------------------------------------------- */
+Simulator::Simulator(double latency, double bandwidth)
+  : defaultLatency(latency), defaultBandwidth(bandwidth), headerBytes(20),
+    queueLimit(0), verbose(0), clock(0), scheduled(0)
+{
+  SimulationStats none = {0, 0, 0, 0, 0};
+  stats = none;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to set the latency and bandwidth of the link between two Routers,
+   in both directions. */
+/* --------------------------------------------------------------------------- */
+void Simulator::setLink(Router &a, Router &b, double latency, double bandwidth) {
+  int num_a = a.getNumber();
+  int num_b = b.getNumber();
+  links[pair<int, int>(min(num_a, num_b), max(num_a, num_b))] =
+    pair<double, double>(latency, bandwidth);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to set the bytes added to every Message for its header, the
+   number of Messages a port holds before it drops more, and whether Hosts
+   print the Messages they receive. */
+/* --------------------------------------------------------------------------- */
+void Simulator::setHeaderBytes(int bytes) {
+  headerBytes = bytes;
+}
+
+void Simulator::setQueueLimit(unsigned int limit) {
+  queueLimit = limit;
+}
+
+void Simulator::setVerbose(bool v) {
+  verbose = v;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the port from one Router or Host to the next, setting
+   it up on first use. Links between two Routers may have been set apart from
+   the default; links to Hosts always have the default. */
+/* --------------------------------------------------------------------------- */
+Simulator::Port &Simulator::portFor(const void *from, const void *to,
+                                    int from_num, int to_num) {
+  pair<const void *, const void *> key(from, to);
+  unordered_map<pair<const void *, const void *>, Port, PortHash>::iterator found =
+    ports.find(key);
+  if (found != ports.end()) {
+    return found->second;
+  }
+
+  Port &port = ports[key];
+  port.latency = defaultLatency;
+  port.bandwidth = defaultBandwidth;
+  if ((from_num >= 0) && (to_num >= 0)) {
+    map<pair<int, int>, pair<double, double> >::iterator link =
+      links.find(pair<int, int>(min(from_num, to_num), max(from_num, to_num)));
+    if (link != links.end()) {
+      port.latency = (link->second).first;
+      port.bandwidth = (link->second).second;
+    }
+  }
+  return port;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to queue a Message at a port, scheduling its arrival at the far
+   end, or dropping it if the port is full. The event e says where the Message
+   is to arrive; its time is filled in here. */
+/* --------------------------------------------------------------------------- */
+void Simulator::transmit(Port &port, Event &e) {
+  // Messages which have finished transmitting have left the port.
+  while (!port.finishing.empty() && (port.finishing.front() <= clock)) {
+    port.finishing.pop_front();
+  }
+  if ((queueLimit > 0) && (port.finishing.size() >= queueLimit)) {
+    discard(e.message);
+    stats.dropped++;
+    return;
+  }
+
+  // The Message starts once those ahead of it have gone.
+  double start = port.finishing.empty() ? clock : port.finishing.back();
+  double bits = 8.0 * (messages[e.message].getLength() + headerBytes);
+  double finish = start + bits / port.bandwidth;
+  port.finishing.push_back(finish);
+
+  e.time = finish + port.latency;
+  e.order = scheduled++;
+  events.push_back(e);
+  push_heap(events.begin(), events.end(), Later());
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to put a Message in a free slot of messages, returning the slot. */
+/* --------------------------------------------------------------------------- */
+unsigned int Simulator::store(Message &&m) {
+  if (unusedMessages.empty()) {
+    messages.push_back(move(m));
+    return messages.size() - 1;
+  }
+  unsigned int slot = unusedMessages.back();
+  unusedMessages.pop_back();
+  messages[slot] = move(m);
+  return slot;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to free a slot once its Message has been delivered or dropped,
+   letting go of its Payload. */
+/* --------------------------------------------------------------------------- */
+void Simulator::discard(unsigned int slot) {
+  messages[slot] = Message(-1, -1, Payload());
+  unusedMessages.push_back(slot);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function for a Host to send a Message now: it crosses the link from the
+   Host to its Router. */
+/* --------------------------------------------------------------------------- */
+void Simulator::send(Host &from, int destination, const Payload &payload) {
+  stats.sent++;
+  Router *r = from.getConnection();
+  if (r == NULL) {
+    stats.unroutable++;
+    return;
+  }
+
+  Event e;
+  e.kind = AT_ROUTER;
+  e.router = r;
+  e.host = NULL;
+  e.message = store(Message(from.getNumber(), destination, payload));
+  e.sent = clock;
+  transmit(portFor(&from, r, -1, r->getNumber()), e);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to deal with a Message arriving at a Router, which passes it to the
+   next Router on the way, or to the destination Host if it is connected
+   directly. */
+/* --------------------------------------------------------------------------- */
+void Simulator::arriveAtRouter(Event &e) {
+  Router *here = e.router;
+  Router *next_router;
+  Host *next_host;
+  if (!(here->findNextHop(messages[e.message].getDestination(), next_router, next_host))) {
+    if (verbose) {
+      cout << "Routing of Message Failed at Router " << here->getNumber() << endl << endl;
+    }
+    discard(e.message);
+    stats.unroutable++;
+    return;
+  }
+
+  if (next_host != NULL) {
+    e.kind = AT_HOST;
+    e.router = NULL;
+    e.host = next_host;
+    transmit(portFor(here, next_host, here->getNumber(), -1), e);
+  } else {
+    e.router = next_router;
+    transmit(portFor(here, next_router, here->getNumber(), next_router->getNumber()), e);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to deal with a Message arriving at its destination Host. */
+/* --------------------------------------------------------------------------- */
+void Simulator::arriveAtHost(Event &e) {
+  stats.delivered++;
+  latencies.push_back(e.time - e.sent);
+  if (verbose) {
+    (e.host)->receiveMessage(messages[e.message]);
+  }
+  discard(e.message);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to take the soonest event from the queue and deal with it. */
+/* --------------------------------------------------------------------------- */
+void Simulator::runNext() {
+  pop_heap(events.begin(), events.end(), Later());
+  Event e = events.back();
+  events.pop_back();
+
+  clock = e.time;
+  stats.events++;
+  if (e.kind == AT_ROUTER) {
+    arriveAtRouter(e);
+  } else {
+    arriveAtHost(e);
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to deal with events in order of time: all of them, or those up to
+   a given time, after which the clock is left at that time. */
+/* --------------------------------------------------------------------------- */
+void Simulator::run() {
+  while (!events.empty()) {
+    runNext();
+  }
+}
+
+void Simulator::runUntil(double time) {
+  while (!events.empty() && (events.front().time <= time)) {
+    runNext();
+  }
+  if (clock < time) {
+    clock = time;
+  }
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the simulated time now. */
+/* --------------------------------------------------------------------------- */
+double Simulator::now() {
+  return clock;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the counts so far, and the latency from sending to
+   delivery that the given fraction of delivered Messages did not exceed. */
+/* --------------------------------------------------------------------------- */
+const SimulationStats &Simulator::getStats() {
+  return stats;
+}
+
+double Simulator::latencyPercentile(double fraction) {
+  if (latencies.empty()) {
+    return 0;
+  }
+  unsigned int n = (unsigned int) (fraction * (latencies.size() - 1) + 0.5);
+  if (n >= latencies.size()) {
+    n = latencies.size() - 1;
+  }
+  nth_element(latencies.begin(), latencies.begin() + n, latencies.end());
+  return latencies[n];
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to print the counts and the distribution of delivery latencies, in
+   milliseconds. */
+/* --------------------------------------------------------------------------- */
+void Simulator::printReport() {
+  cout << "Sent " << stats.sent << " messages: " << stats.delivered
+       << " delivered, " << stats.dropped << " dropped at full queues, "
+       << stats.unroutable << " unroutable, in " << stats.events << " events."
+       << endl;
+  if (!latencies.empty()) {
+    double total = 0;
+    for (unsigned int n = 0; n < latencies.size(); n++) {
+      total += latencies[n];
+    }
+    cout << "Latency (ms): mean " << 1000 * total / latencies.size()
+         << ", median " << 1000 * latencyPercentile(0.5)
+         << ", 90% " << 1000 * latencyPercentile(0.9)
+         << ", 99% " << 1000 * latencyPercentile(0.99)
+         << ", max " << 1000 * latencyPercentile(1.0) << endl;
+  }
+  cout << endl;
+}
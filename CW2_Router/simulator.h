@@ -0,0 +1,184 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+#include <vector>
+#include <deque>
+#include <utility>
+#include <map>
+#include <unordered_map>
+
+#include "message.h"
+
+using namespace std;
+
+class Router;
+class Host;
+
+/* --------------------------------------------------------------------------- */
+/* Counts for everything a Simulator has done since it was made. */
+/* --------------------------------------------------------------------------- */
+struct SimulationStats {
+  long events;       // events dealt with.
+  long sent;         // Messages sent by Hosts.
+  long delivered;    // Messages which reached their destination Host.
+  long dropped;      // Messages dropped because a port's queue was full.
+  long unroutable;   // Messages dropped because a Router had no route, or the
+                     // sending Host was not connected.
+};
+
+/* --------------------------------------------------------------------------- */
+/* A discrete-event simulation of Messages crossing a network. Instead of being
+   passed from Router to Router at once, a Message sent by a Host attached to
+   a Simulator (see Host::setSimulator()) becomes a series of events in time:
+   it waits its turn at each port, takes time to transmit according to the
+   link's bandwidth, then arrives at the far end after the link's latency.
+   Routers forward by their forwarding tables as usual. Times are in seconds
+   and bandwidths in bits per second. */
+/* --------------------------------------------------------------------------- */
+class Simulator {
+private:
+  enum EventKind { AT_ROUTER, AT_HOST };
+
+  struct Event {
+    double time;          // when the Message arrives.
+    unsigned long order;  // events at the same time are dealt with in the
+                          // order they were scheduled.
+    EventKind kind;
+    Router *router;       // where the Message arrives: a Router or a Host.
+    Host *host;
+    unsigned int message; // slot of the Message in messages.
+    double sent;          // when the Message was sent.
+  };
+
+  struct Later {
+    bool operator()(const Event &a, const Event &b) const {
+      return (a.time > b.time) || ((a.time == b.time) && (a.order > b.order));
+    }
+  };
+
+  // The sending end of a link, from a Router or Host to the next Router or
+  // Host. Messages leave one at a time, in the order they arrive.
+  struct Port {
+    double latency;
+    double bandwidth;
+    deque<double> finishing;  // when each Message waiting at, or being sent
+                              // from, the port finishes transmitting.
+  };
+
+  struct PortHash {
+    size_t operator()(const pair<const void *, const void *> &p) const {
+      return (size_t) p.first * 31 + (size_t) p.second;
+    }
+  };
+
+  vector<Event> events;     // a heap, soonest first, kept with push_heap()
+                            // and pop_heap().
+
+  vector<Message> messages; // Messages on their way, which stay in place
+                            // while their events move about the heap.
+  vector<unsigned int> unusedMessages;  // slots of messages free for reuse.
+
+  unordered_map<pair<const void *, const void *>, Port, PortHash> ports;
+
+  map<pair<int, int>, pair<double, double> > links;  // (Router, Router) ->
+                                                     // (latency, bandwidth),
+                                                     // for links set apart
+                                                     // from the default.
+
+  double defaultLatency;
+  double defaultBandwidth;
+  int headerBytes;          // added to the length of every Message.
+  unsigned int queueLimit;  // Messages a port holds before dropping more; 0
+                            // for no limit.
+  bool verbose;             // TRUE to have Hosts print Messages they receive.
+
+  double clock;
+  unsigned long scheduled;
+  SimulationStats stats;
+  vector<double> latencies; // of every Message delivered.
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the port from one Router or Host to the next, setting
+   it up on first use. */
+/* --------------------------------------------------------------------------- */
+  Port &portFor(const void *from, const void *to, int from_num, int to_num);
+
+/* --------------------------------------------------------------------------- */
+/* Function to queue a Message at a port, scheduling its arrival at the far
+   end, or dropping it if the port is full. */
+/* --------------------------------------------------------------------------- */
+  void transmit(Port &port, Event &e);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to put a Message in a free slot of messages, returning the slot,
+   and to free a slot once its Message has been delivered or dropped. */
+/* --------------------------------------------------------------------------- */
+  unsigned int store(Message &&m);
+  void discard(unsigned int slot);
+
+/* --------------------------------------------------------------------------- */
+/* Function to take the soonest event from the queue and deal with it. */
+/* --------------------------------------------------------------------------- */
+  void runNext();
+
+/* --------------------------------------------------------------------------- */
+/* Functions to deal with a Message arriving at a Router, which passes it on,
+   and at a Host, which receives it. */
+/* --------------------------------------------------------------------------- */
+  void arriveAtRouter(Event &e);
+  void arriveAtHost(Event &e);
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for a Simulator whose links all have the given latency
+   and bandwidth, unless set otherwise. */
+/* --------------------------------------------------------------------------- */
+  Simulator(double latency = 0.001, double bandwidth = 1e9);
+
+/* --------------------------------------------------------------------------- */
+/* Function to set the latency and bandwidth of the link between two Routers,
+   in both directions. Must be called before any Message crosses the link. */
+/* --------------------------------------------------------------------------- */
+  void setLink(Router &a, Router &b, double latency, double bandwidth);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to set the bytes added to every Message for its header, the
+   number of Messages a port holds before it drops more (0 for no limit), and
+   whether Hosts print the Messages they receive. */
+/* --------------------------------------------------------------------------- */
+  void setHeaderBytes(int bytes);
+  void setQueueLimit(unsigned int limit);
+  void setVerbose(bool v);
+
+/* --------------------------------------------------------------------------- */
+/* Function for a Host to send a Message now, as Host::send() does for a Host
+   attached to the Simulator. */
+/* --------------------------------------------------------------------------- */
+  void send(Host &from, int destination, const Payload &payload);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to deal with events in order of time: all of them, or those up to
+   a given time, after which the clock is left at that time. */
+/* --------------------------------------------------------------------------- */
+  void run();
+  void runUntil(double time);
+
+/* --------------------------------------------------------------------------- */
+/* Function to return the simulated time now. */
+/* --------------------------------------------------------------------------- */
+  double now();
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the counts so far, and the latency from sending to
+   delivery that the given fraction of delivered Messages did not exceed
+   (0.5 for the median). */
+/* --------------------------------------------------------------------------- */
+  const SimulationStats &getStats();
+  double latencyPercentile(double fraction);
+
+/* --------------------------------------------------------------------------- */
+/* Function to print the counts and the distribution of delivery latencies. */
+/* --------------------------------------------------------------------------- */
+  void printReport();
+};
+
+#endif
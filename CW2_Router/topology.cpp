@@ -0,0 +1,204 @@
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "topology.h"
+#include "router.h"
+
+using namespace std;
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for the Topology of a network of one Router. */
+/* --------------------------------------------------------------------------- */
+Topology::Topology(Router *r) {
+  (this->routers)[r->getNumber()] = r;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to check whether a Router or Host address is in use in the
+   network. */
+/* --------------------------------------------------------------------------- */
+bool Topology::hasRouter(int num) {
+  return (this->routers).count(num) > 0;
+}
+
+bool Topology::hasHost(int num) {
+  return (this->hosts).count(num) > 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the number of Routers and of Hosts in the network. */
+/* --------------------------------------------------------------------------- */
+int Topology::routerCount() {
+  return (this->routers).size();
+}
+
+int Topology::hostCount() {
+  return (this->hosts).size();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to record a Host connecting to, or disconnecting from, a Router
+   in the network. */
+/* --------------------------------------------------------------------------- */
+void Topology::addHost(int num) {
+  (this->hosts).insert(num);
+}
+
+void Topology::removeHost(int num) {
+  (this->hosts).erase(num);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to remove a Router which no longer exists from the network.
+   Returns TRUE if the network is left empty. */
+/* --------------------------------------------------------------------------- */
+bool Topology::removeRouter(Router *r) {
+  (this->routers).erase(r->getNumber());
+  const multimap<int, Host *> &connected = r->getNeighborHosts();
+  for (multimap<int, Host *>::const_iterator hi = connected.begin();
+       hi != connected.end();
+       hi++)
+  {
+    (this->hosts).erase(hi->first);
+  }
+  return (this->routers).empty();
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to move a Router, and its Hosts, from this Topology to another. */
+/* --------------------------------------------------------------------------- */
+void Topology::moveRouter(Router *r, Topology *to) {
+  (this->routers).erase(r->getNumber());
+  (to->routers)[r->getNumber()] = r;
+
+  const multimap<int, Host *> &connected = r->getNeighborHosts();
+  for (multimap<int, Host *>::const_iterator hi = connected.begin();
+       hi != connected.end();
+       hi++)
+  {
+    (this->hosts).erase(hi->first);
+    (to->hosts).insert(hi->first);
+  }
+  r->setTopology(to);
+}
+
+/* --------------------------------------------------------------------------- */
+/* Functions to check whether two separate networks both use a Router address,
+   or both use a Host address. */
+/* --------------------------------------------------------------------------- */
+bool Topology::sharesRouterAddress(Topology *other) {
+  Topology *small = this;
+  Topology *large = other;
+  if ((small->routers).size() > (large->routers).size()) {
+    small = other;
+    large = this;
+  }
+  for (unordered_map<int, Router *>::iterator i = (small->routers).begin();
+       i != (small->routers).end();
+       i++)
+  {
+    if (large->hasRouter(i->first)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+bool Topology::sharesHostAddress(Topology *other) {
+  Topology *small = this;
+  Topology *large = other;
+  if ((small->hosts).size() > (large->hosts).size()) {
+    small = other;
+    large = this;
+  }
+  for (unordered_set<int>::iterator i = (small->hosts).begin();
+       i != (small->hosts).end();
+       i++)
+  {
+    if (large->hasHost(*i)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to record that two Routers have been connected, merging their
+   networks if they were separate: the Routers of the smaller network move to
+   the Topology of the larger, and the smaller Topology is deleted. */
+/* --------------------------------------------------------------------------- */
+void Topology::join(Router *a, Router *b) {
+  Topology *large = a->getTopology();
+  Topology *small = b->getTopology();
+  if (large == small) {
+    return;
+  }
+  if ((small->routers).size() > (large->routers).size()) {
+    large = b->getTopology();
+    small = a->getTopology();
+  }
+
+  vector<Router *> moving;
+  for (unordered_map<int, Router *>::iterator i = (small->routers).begin();
+       i != (small->routers).end();
+       i++)
+  {
+    moving.push_back(i->second);
+  }
+  for (unsigned int n = 0; n < moving.size(); n++) {
+    small->moveRouter(moving[n], large);
+  }
+  delete small;
+}
+
+/* --------------------------------------------------------------------------- */
+/* Function to record that two Routers have been disconnected. The network is
+   searched outwards from both Routers at once, one Router from each side in
+   turn. If the searches meet, the network is still connected. Otherwise the
+   search which runs out first has found the whole of the smaller part, which
+   moves to a new Topology, so the cost is in proportion to the smaller part. */
+/* --------------------------------------------------------------------------- */
+void Topology::split(Router *a, Router *b) {
+  if (a->getTopology() != b->getTopology()) {
+    return;
+  }
+
+  unordered_map<Router *, int> side;   // Router -> search which found it.
+  vector<Router *> found[2];            // Routers found by each search, in the
+                                        // order they are to be looked at.
+  unsigned int next[2] = {0, 0};        // next Router each search looks at.
+
+  found[0].push_back(a);
+  found[1].push_back(b);
+  side[a] = 0;
+  side[b] = 1;
+
+  int s = 0;
+  while (next[s] < found[s].size()) {
+    Router *r = found[s][next[s]++];
+    const multimap<int, Router *> &neighbors = r->getNeighborRouters();
+    for (multimap<int, Router *>::const_iterator ri = neighbors.begin();
+         ri != neighbors.end();
+         ri++)
+    {
+      unordered_map<Router *, int>::iterator seen = side.find(ri->second);
+      if (seen == side.end()) {
+        side[ri->second] = s;
+        found[s].push_back(ri->second);
+      } else if (seen->second != s) {
+        // The searches have met, so the Routers are still connected.
+        return;
+      }
+    }
+    s = 1 - s;
+  }
+
+  // Search s ran out, so holds the smaller part of the network.
+  Topology *old_topology = a->getTopology();
+  Topology *new_topology = new Topology();
+  for (unsigned int n = 0; n < found[s].size(); n++) {
+    old_topology->moveRouter(found[s][n], new_topology);
+  }
+}
@@ -0,0 +1,92 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace std;
+
+class Router;
+
+/* --------------------------------------------------------------------------- */
+/* The Routers and Hosts making up one network of connected Routers. Every
+   Router points to the Topology of its network, so whether a Router or Host
+   address is in use in a network is one lookup, and so is whether two Routers
+   are in the same network. When two networks are connected, the smaller is
+   merged into the larger, so that a Router moves to a new Topology at most
+   log(n) times however a network of n Routers is put together. */
+/* --------------------------------------------------------------------------- */
+class Topology {
+private:
+  unordered_map<int, Router *> routers;  // Routers in the network, by address.
+
+  unordered_set<int> hosts;              // addresses of the Hosts connected to
+                                         // them.
+
+/* --------------------------------------------------------------------------- */
+/* Constructor function for the Topology of an empty network, for Routers to
+   be moved to. */
+/* --------------------------------------------------------------------------- */
+  Topology() {}
+
+/* --------------------------------------------------------------------------- */
+/* Function to move a Router, and its Hosts, from this Topology to another. */
+/* --------------------------------------------------------------------------- */
+  void moveRouter(Router *r, Topology *to);
+
+public:
+/* --------------------------------------------------------------------------- */
+/* Constructor function for the Topology of a network of one Router. */
+/* --------------------------------------------------------------------------- */
+  Topology(Router *r);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to check whether a Router or Host address is in use in the
+   network. */
+/* --------------------------------------------------------------------------- */
+  bool hasRouter(int num);
+  bool hasHost(int num);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to return the number of Routers and of Hosts in the network. */
+/* --------------------------------------------------------------------------- */
+  int routerCount();
+  int hostCount();
+
+/* --------------------------------------------------------------------------- */
+/* Functions to record a Host connecting to, or disconnecting from, a Router
+   in the network. */
+/* --------------------------------------------------------------------------- */
+  void addHost(int num);
+  void removeHost(int num);
+
+/* --------------------------------------------------------------------------- */
+/* Function to remove a Router which no longer exists from the network.
+   Returns TRUE if the network is left empty, in which case the Topology
+   should be deleted. */
+/* --------------------------------------------------------------------------- */
+  bool removeRouter(Router *r);
+
+/* --------------------------------------------------------------------------- */
+/* Functions to check whether two separate networks both use a Router address,
+   or both use a Host address. Only the addresses of the smaller network are
+   looked up in the larger. */
+/* --------------------------------------------------------------------------- */
+  bool sharesRouterAddress(Topology *other);
+  bool sharesHostAddress(Topology *other);
+
+/* --------------------------------------------------------------------------- */
+/* Function to record that two Routers have been connected, merging their
+   networks if they were separate. */
+/* --------------------------------------------------------------------------- */
+  static void join(Router *a, Router *b);
+
+/* --------------------------------------------------------------------------- */
+/* Function to record that two Routers have been disconnected. If that leaves
+   them in separate networks, the part of the network on one side is given a
+   Topology of its own. */
+/* --------------------------------------------------------------------------- */
+  static void split(Router *a, Router *b);
+};
+
+#endif